@@ -0,0 +1,38 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#include "IncludesManager.h"
+
+BatchRunner::BatchRunner(JobSystem& _jobs) : jobs(_jobs)
+{
+}
+
+BatchStats BatchRunner::Run(std::vector<World*>& worlds, unsigned int steps)
+{
+    Timer timer;
+    timer.Start();
+
+    jobs.ParallelFor((unsigned int)worlds.size(), 1, [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int i = begin; i < end; i++)
+        {
+            for (unsigned int j = 0; j < steps; j++)
+                worlds[i]->Step();
+        }
+    });
+
+    timer.Stop();
+
+    BatchStats stats;
+    stats.worldSteps = (unsigned long long)worlds.size() * steps;
+    stats.seconds = timer.Elapsed();
+    if (stats.seconds > 0.0f)
+        stats.worldStepsPerSecond = stats.worldSteps / stats.seconds;
+    return stats;
+}
+
+unsigned int BatchRunner::ThreadCount() const
+{
+    return jobs.ThreadCount();
+}
@@ -0,0 +1,42 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+class World;
+class JobSystem;
+
+
+// result of one batch run
+struct BatchStats
+{
+    unsigned long long worldSteps = 0;   // number of World::Step calls
+    float seconds = 0.0f;                // wall time of the whole batch
+    float worldStepsPerSecond = 0.0f;    // throughput
+};
+
+
+// BatchRunner class - steps many independent worlds on threads of a job system
+// every world is a single job, so worlds are never shared between threads
+class BatchRunner
+{
+public:
+    // constructor
+    // _jobs - job system whose threads step worlds
+    BatchRunner(JobSystem& _jobs);
+
+    // steps every world from the list given number of times and blocks until all of them are done
+    // worlds - independent worlds to simulate
+    // steps - number of steps to carry out in each world
+    BatchStats Run(std::vector<World*>& worlds, unsigned int steps);
+
+    // returns number of threads stepping worlds
+    unsigned int ThreadCount() const;
+
+private:
+    JobSystem& jobs;
+};
+
+#endif // BATCHRUNNER_H
@@ -0,0 +1,423 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+// Benchmark - standard scenes stepped headless with given numbers of bodies and threads
+// usage: Benchmark [--scene pyramid,ballpit,rain,mixed] [--bodies 1000,4000] [--threads 1,2,4]
+//                  [--steps 300] [--warmup 60] [--seed 1] [--out results.json]
+// every combination of scene, number of bodies and number of threads is one run; results are written as JSON
+// bodies of a result are the dynamic bodies of its scene, static floors and walls aren't counted
+// rain spawns its bodies during the first rainSpawnSteps steps, so its warmup is never shorter than that
+// peak working set is the peak of the whole process so far, so for exact peaks run one combination per process
+// Benchmark --narrowphase ... measures routines of Collision.cpp instead, see NarrowphaseBenchmark.h
+
+#include "IncludesManager.h"
+#include "NarrowphaseBenchmark.h"
+#include <Psapi.h>
+#include <cstdio>
+#include <string>
+
+#pragma comment(lib, "psapi.lib")
+
+
+// parameters of all runs
+struct BenchmarkOptions
+{
+    std::vector<std::string> scenes = { "pyramid", "ballpit", "rain", "mixed" };
+    std::vector<unsigned int> bodies = { 1000 };
+    std::vector<unsigned int> threads = { 1 };
+    unsigned int steps = 300;
+    unsigned int warmup = 60;
+    unsigned int seed = 1;
+    std::string out;
+};
+
+
+// number of steps during which the rain spawns its bodies
+static const unsigned int rainSpawnSteps = 120;
+
+
+// result of one run
+struct BenchmarkResult
+{
+    std::string scene;
+    unsigned int bodies = 0;        // dynamic bodies only
+    unsigned int threads = 0;
+    unsigned int warmup = 0;        // steps stepped before measuring
+    unsigned int steps = 0;
+    double stepsPerSecond = 0.0;
+    double msMin = 0.0, msMean = 0.0, msP50 = 0.0, msP90 = 0.0, msP99 = 0.0, msMax = 0.0;
+    size_t peakWorkingSet = 0;
+    size_t workingSet = 0;
+};
+
+
+// adds static box with given half sizes
+static RigidBody* AddStatic(World& world, float x, float y, float halfWidth, float halfHeight)
+{
+    Rect rect(halfWidth, halfHeight);
+    BodyDefinition definition;
+    definition.position = Vector2D(x, y);
+    definition.isStatic = true;
+    return world.Add(&rect, definition);
+}
+
+// adds random convex polygon like the left mouse button in Fancy World
+static void AddMousePolygon(World& world, float x, float y)
+{
+    int count = (int)random(5, MaxPolyVertexCount);
+    Vector2D vertices[MaxPolyVertexCount];
+    for (int i = 0; i < count; i++)
+    {
+        vertices[i].x = random(-7.0, 7.0);
+        vertices[i].y = random(-7.0, 7.0);
+    }
+
+    Poly poly(vertices, count);
+    BodyDefinition definition;
+    definition.position = Vector2D(x, y);
+    definition.orientation = random(-PI, PI);
+    definition.restitution = 0.4f;
+    definition.kineticFriction = 0.2f;
+    definition.staticFriction = 0.4f;
+    world.Add(&poly, definition);
+}
+
+// pyramid of boxes on a floor; the number of bodies is rounded down to a full pyramid
+static void BuildPyramid(World& world, unsigned int bodies)
+{
+    unsigned int rows = 1;
+    while ((rows + 1) * (rows + 2) / 2 <= bodies)
+        rows++;
+
+    const float size = 1.0f;
+    AddStatic(world, 0.0f, 1.0f, std::max(50.0f, rows * size), 1.0f);
+
+    std::vector<const Shape*> shapes;
+    std::vector<BodyDefinition> definitions;
+    Rect box(0.5f * size, 0.5f * size);
+    for (unsigned int row = 0; row < rows; row++)
+    {
+        unsigned int count = rows - row;
+        for (unsigned int i = 0; i < count; i++)
+        {
+            BodyDefinition definition;
+            definition.position = Vector2D((i - 0.5f * (count - 1)) * size, -0.5f * size - row * size * 1.02f);
+            definition.restitution = 0.0f;
+            shapes.push_back(&box);
+            definitions.push_back(definition);
+        }
+    }
+    world.AddBatch(shapes.data(), definitions.data(), (unsigned int)shapes.size());
+}
+
+// grid of circles falling into a box with walls
+static void BuildBallPit(World& world, unsigned int bodies)
+{
+    unsigned int columns = std::max(1u, (unsigned int)sqrtf((float)bodies));
+    const float spacing = 2.2f;
+    float halfWidth = 0.5f * columns * spacing + 2.0f;
+    float height = (bodies / columns + 1) * spacing;
+
+    AddStatic(world, 0.0f, 1.0f, halfWidth + 1.0f, 1.0f);
+    AddStatic(world, -halfWidth, -0.5f * height, 1.0f, 0.5f * height + 1.0f);
+    AddStatic(world, halfWidth, -0.5f * height, 1.0f, 0.5f * height + 1.0f);
+
+    std::vector<Circle> circles;
+    std::vector<BodyDefinition> definitions(bodies);
+    circles.reserve(bodies);
+    for (unsigned int i = 0; i < bodies; i++)
+    {
+        circles.push_back(Circle(random(0.5f, 1.0f)));
+        definitions[i].position = Vector2D(((i % columns) - 0.5f * (columns - 1)) * spacing + random(-0.1f, 0.1f),
+            -2.0f - (i / columns) * spacing);
+        definitions[i].restitution = 0.3f;
+    }
+
+    std::vector<const Shape*> shapes(bodies);
+    for (unsigned int i = 0; i < bodies; i++)
+        shapes[i] = &circles[i];
+    world.AddBatch(shapes.data(), definitions.data(), bodies);
+}
+
+// floor for polygons which fall like clicks of the left mouse button in Fancy World
+static void BuildRain(World& world, unsigned int bodies)
+{
+    float halfWidth = std::max(40.0f, sqrtf((float)bodies) * 8.0f);
+    AddStatic(world, 0.0f, 1.0f, halfWidth, 1.0f);
+}
+
+// spawns next drops of the rain; all bodies fall during the first rainSpawnSteps steps
+static void UpdateRain(World& world, unsigned int bodies, unsigned int step)
+{
+    float halfWidth = std::max(40.0f, sqrtf((float)bodies) * 8.0f);
+    unsigned int perStep = (bodies + rainSpawnSteps - 1) / rainSpawnSteps;
+    unsigned int spawned = std::min(bodies, step * perStep);
+    unsigned int count = std::min(perStep, bodies - spawned);
+    for (unsigned int i = 0; i < count; i++)
+        AddMousePolygon(world, random(-halfWidth + 7.0f, halfWidth - 7.0f), random(-60.0f, -10.0f));
+}
+
+// circles, small polygons and boxes dropped on a floor
+static void BuildMixed(World& world, unsigned int bodies)
+{
+    unsigned int columns = std::max(1u, (unsigned int)sqrtf((float)bodies));
+    const float spacing = 3.5f;
+    float halfWidth = 0.5f * columns * spacing + 2.0f;
+    AddStatic(world, 0.0f, 1.0f, halfWidth, 1.0f);
+
+    for (unsigned int i = 0; i < bodies; i++)
+    {
+        BodyDefinition definition;
+        definition.position = Vector2D(((i % columns) - 0.5f * (columns - 1)) * spacing + random(-0.3f, 0.3f),
+            -3.0f - (i / columns) * spacing);
+        definition.orientation = random(-PI, PI);
+        definition.restitution = 0.3f;
+
+        switch (i % 3)
+        {
+        case 0:
+        {
+            Circle circle(random(0.5f, 1.5f));
+            world.Add(&circle, definition);
+        }
+        break;
+        case 1:
+        {
+            int count = (int)random(5, 9);
+            Vector2D vertices[MaxPolyVertexCount];
+            for (int k = 0; k < count; k++)
+            {
+                vertices[k].x = random(-1.5f, 1.5f);
+                vertices[k].y = random(-1.5f, 1.5f);
+            }
+            Poly poly(vertices, count);
+            world.Add(&poly, definition);
+        }
+        break;
+        default:
+        {
+            Rect box(random(0.5f, 1.5f), random(0.5f, 1.5f));
+            world.Add(&box, definition);
+        }
+        break;
+        }
+    }
+}
+
+// returns memory counters of the process
+static PROCESS_MEMORY_COUNTERS GetMemory()
+{
+    PROCESS_MEMORY_COUNTERS counters;
+    memset(&counters, 0, sizeof(counters));
+    counters.cb = sizeof(counters);
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters;
+}
+
+// returns value at given fraction of sorted values
+static double Percentile(const std::vector<double>& sorted, double fraction)
+{
+    size_t index = (size_t)(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// builds a scene and measures its steps; returns false for unknown scene
+static bool Run(const std::string& scene, unsigned int bodies, unsigned int threads, const BenchmarkOptions& options, BenchmarkResult& result)
+{
+    if (scene != "pyramid" && scene != "ballpit" && scene != "rain" && scene != "mixed")
+        return false;
+
+    srand(options.seed);
+    JobSystem jobs(threads);
+    World world(defaultDt, defaultIterations);
+    world.SetJobSystem(&jobs);
+
+    if (scene == "pyramid")
+        BuildPyramid(world, bodies);
+    else if (scene == "ballpit")
+        BuildBallPit(world, bodies);
+    else if (scene == "rain")
+        BuildRain(world, bodies);
+    else
+        BuildMixed(world, bodies);
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    double msPerTick = 1000.0 / (double)frequency.QuadPart;
+
+    // measured steps of the rain start once all its bodies are spawned
+    unsigned int warmup = scene == "rain" ? std::max(options.warmup, rainSpawnSteps) : options.warmup;
+
+    std::vector<double> times;
+    times.reserve(options.steps);
+    for (unsigned int step = 0; step < warmup + options.steps; step++)
+    {
+        if (scene == "rain")
+            UpdateRain(world, bodies, step);
+
+        long long start = Profiler::Now();
+        world.Step();
+        long long end = Profiler::Now();
+
+        if (step >= warmup)
+            times.push_back((end - start) * msPerTick);
+    }
+
+    PROCESS_MEMORY_COUNTERS memory = GetMemory();
+
+    result.scene = scene;
+    result.bodies = 0;
+    for (unsigned int i = 0; i < world.bodies.size(); i++)
+        if (world.bodies[i]->inverseMass != 0.0f)
+            result.bodies++;
+    result.threads = jobs.ThreadCount();
+    result.warmup = warmup;
+    result.steps = options.steps;
+    result.peakWorkingSet = memory.PeakWorkingSetSize;
+    result.workingSet = memory.WorkingSetSize;
+    if (times.empty())
+        return true;
+
+    double total = 0.0;
+    for (unsigned int i = 0; i < times.size(); i++)
+        total += times[i];
+    std::sort(times.begin(), times.end());
+
+    result.stepsPerSecond = total > 0.0 ? times.size() * 1000.0 / total : 0.0;
+    result.msMin = times.front();
+    result.msMean = total / times.size();
+    result.msP50 = Percentile(times, 0.50);
+    result.msP90 = Percentile(times, 0.90);
+    result.msP99 = Percentile(times, 0.99);
+    result.msMax = times.back();
+    return true;
+}
+
+// splits comma separated list
+static std::vector<std::string> Split(const char* list)
+{
+    std::vector<std::string> items;
+    std::string item;
+    for (const char* c = list; ; c++)
+    {
+        if (*c == ',' || *c == '\0')
+        {
+            if (!item.empty())
+                items.push_back(item);
+            item.clear();
+            if (*c == '\0')
+                break;
+        }
+        else
+            item += *c;
+    }
+    return items;
+}
+
+// splits comma separated list of numbers
+static std::vector<unsigned int> SplitNumbers(const char* list)
+{
+    std::vector<std::string> items = Split(list);
+    std::vector<unsigned int> numbers;
+    for (unsigned int i = 0; i < items.size(); i++)
+        numbers.push_back((unsigned int)strtoul(items[i].c_str(), nullptr, 10));
+    return numbers;
+}
+
+// reads options from command line; returns false for unknown option
+static bool ParseOptions(int argc, char** argv, BenchmarkOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (i + 1 >= argc)
+            return false;
+        const char* value = argv[++i];
+
+        if (option == "--scene")
+            options.scenes = Split(value);
+        else if (option == "--bodies")
+            options.bodies = SplitNumbers(value);
+        else if (option == "--threads")
+            options.threads = SplitNumbers(value);
+        else if (option == "--steps")
+            options.steps = (unsigned int)strtoul(value, nullptr, 10);
+        else if (option == "--warmup")
+            options.warmup = (unsigned int)strtoul(value, nullptr, 10);
+        else if (option == "--seed")
+            options.seed = (unsigned int)strtoul(value, nullptr, 10);
+        else if (option == "--out")
+            options.out = value;
+        else
+            return false;
+    }
+    return true;
+}
+
+// writes results as JSON
+static void WriteResults(FILE* file, const BenchmarkOptions& options, const std::vector<BenchmarkResult>& results)
+{
+    fprintf(file, "{\n  \"steps\": %u,\n  \"warmup\": %u,\n  \"seed\": %u,\n  \"hardwareThreads\": %u,\n  \"runs\": [",
+        options.steps, options.warmup, options.seed, std::thread::hardware_concurrency());
+    for (unsigned int i = 0; i < results.size(); i++)
+    {
+        const BenchmarkResult& r = results[i];
+        fprintf(file, "%s\n    {\"scene\": \"%s\", \"bodies\": %u, \"threads\": %u, \"warmup\": %u, \"steps\": %u, \"stepsPerSecond\": %.3f, "
+            "\"msPerStep\": {\"min\": %.4f, \"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f}, "
+            "\"peakWorkingSetBytes\": %zu, \"workingSetBytes\": %zu}",
+            i ? "," : "", r.scene.c_str(), r.bodies, r.threads, r.warmup, r.steps, r.stepsPerSecond,
+            r.msMin, r.msMean, r.msP50, r.msP90, r.msP99, r.msMax, r.peakWorkingSet, r.workingSet);
+    }
+    fprintf(file, "\n  ]\n}\n");
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && strcmp(argv[1], "--narrowphase") == 0)
+    {
+        int code = RunNarrowphaseBenchmark(argc - 2, argv + 2);
+        if (code)
+            fprintf(stderr, "usage: Benchmark --narrowphase [--vertices 3,4,8,128] [--min-time 0.05] [--seed 1] [--out results.json]\n");
+        return code;
+    }
+
+    BenchmarkOptions options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        fprintf(stderr, "usage: Benchmark [--scene pyramid,ballpit,rain,mixed] [--bodies 1000,4000] [--threads 1,2,4] "
+            "[--steps 300] [--warmup 60] [--seed 1] [--out results.json]\n");
+        return 1;
+    }
+
+    std::vector<BenchmarkResult> results;
+    for (unsigned int s = 0; s < options.scenes.size(); s++)
+    {
+        for (unsigned int b = 0; b < options.bodies.size(); b++)
+        {
+            for (unsigned int t = 0; t < options.threads.size(); t++)
+            {
+                BenchmarkResult result;
+                if (!Run(options.scenes[s], options.bodies[b], options.threads[t], options, result))
+                {
+                    fprintf(stderr, "unknown scene %s\n", options.scenes[s].c_str());
+                    return 1;
+                }
+                fprintf(stderr, "%s bodies %u threads %u: %.1f steps/s, p99 %.3f ms\n",
+                    result.scene.c_str(), result.bodies, result.threads, result.stepsPerSecond, result.msP99);
+                results.push_back(result);
+            }
+        }
+    }
+
+    FILE* file = stdout;
+    if (!options.out.empty() && fopen_s(&file, options.out.c_str(), "w") != 0)
+    {
+        fprintf(stderr, "can't write %s\n", options.out.c_str());
+        return 1;
+    }
+    WriteResults(file, options, results);
+    if (file != stdout)
+        fclose(file);
+    return 0;
+}
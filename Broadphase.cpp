@@ -0,0 +1,389 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#include "IncludesManager.h"
+
+AABBTree::AABBTree()
+{
+    root = nullNode;
+    freeList = nullNode;
+}
+
+int AABBTree::CreateProxy(const AABB& box, RigidBody* body)
+{
+    int proxy = CreateDetachedProxy(box, body);
+    InsertLeaf(proxy);
+    return proxy;
+}
+
+int AABBTree::CreateDetachedProxy(const AABB& box, RigidBody* body)
+{
+    int proxy = AllocateNode();
+    nodes[proxy].box = box.Extend(aabbMargin);
+    nodes[proxy].body = body;
+    nodes[proxy].height = 0;
+    return proxy;
+}
+
+void AABBTree::DestroyProxy(int proxy)
+{
+    assert(nodes[proxy].IsLeaf());
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+}
+
+bool AABBTree::MoveProxy(int proxy, const AABB& box)
+{
+    assert(nodes[proxy].IsLeaf());
+    if (nodes[proxy].box.Contains(box))
+        return false;
+
+    RemoveLeaf(proxy);
+    nodes[proxy].box = box.Extend(aabbMargin);
+    InsertLeaf(proxy);
+    return true;
+}
+
+void AABBTree::Rebuild()
+{
+    // leaves are kept, internal nodes are built again
+    leaves.clear();
+    for (int i = 0; i < (int)nodes.size(); i++)
+    {
+        if (nodes[i].height < 0)
+            continue;
+
+        if (nodes[i].IsLeaf())
+        {
+            nodes[i].parent = nullNode;
+            leaves.push_back(i);
+        }
+        else
+        {
+            FreeNode(i);
+        }
+    }
+
+    // centers are calculated once, because they are compared many times while splitting
+    centers.resize(nodes.size());
+    for (unsigned int i = 0; i < leaves.size(); i++)
+        centers[leaves[i]] = nodes[leaves[i]].box.Center();
+
+    root = leaves.empty() ? nullNode : BuildTopDown(leaves.data(), (int)leaves.size());
+    if (root != nullNode)
+        nodes[root].parent = nullNode;
+}
+
+void AABBTree::Clear()
+{
+    nodes.clear();
+    root = nullNode;
+    freeList = nullNode;
+}
+
+int AABBTree::GetHeight() const
+{
+    return root == nullNode ? 0 : nodes[root].height;
+}
+
+int AABBTree::AllocateNode()
+{
+    if (freeList == nullNode)
+    {
+        TreeNode node;
+        node.height = -1;
+        node.parent = freeList;
+        nodes.push_back(node);
+        freeList = (int)nodes.size() - 1;
+    }
+
+    int node = freeList;
+    freeList = nodes[node].parent;
+    nodes[node].parent = nullNode;
+    nodes[node].child1 = nullNode;
+    nodes[node].child2 = nullNode;
+    nodes[node].height = 0;
+    nodes[node].body = nullptr;
+    return node;
+}
+
+void AABBTree::FreeNode(int node)
+{
+    nodes[node].parent = freeList;
+    nodes[node].height = -1;
+    freeList = node;
+}
+
+void AABBTree::InsertLeaf(int leaf)
+{
+    if (root == nullNode)
+    {
+        root = leaf;
+        nodes[root].parent = nullNode;
+        return;
+    }
+
+    // finding the best sibling - cost of a node is perimeter of its box,
+    // children are visited only if they can be cheaper than the current node
+    AABB leafBox = nodes[leaf].box;
+    int index = root;
+    while (!nodes[index].IsLeaf())
+    {
+        int child1 = nodes[index].child1;
+        int child2 = nodes[index].child2;
+
+        float area = nodes[index].box.Perimeter();
+        float combinedArea = nodes[index].box.Combine(leafBox).Perimeter();
+
+        // cost of creating a new parent for this node and the new leaf
+        float cost = 2.0f * combinedArea;
+
+        // minimum cost of pushing the leaf further down the tree
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        float cost1 = leafBox.Combine(nodes[child1].box).Perimeter() + inheritanceCost;
+        if (!nodes[child1].IsLeaf())
+            cost1 -= nodes[child1].box.Perimeter();
+
+        float cost2 = leafBox.Combine(nodes[child2].box).Perimeter() + inheritanceCost;
+        if (!nodes[child2].IsLeaf())
+            cost2 -= nodes[child2].box.Perimeter();
+
+        if (cost < cost1 && cost < cost2)
+            break;
+
+        index = cost1 < cost2 ? child1 : child2;
+    }
+
+    int sibling = index;
+
+    // creating a new parent
+    int oldParent = nodes[sibling].parent;
+    int newParent = AllocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].box = leafBox.Combine(nodes[sibling].box);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent != nullNode)
+    {
+        if (nodes[oldParent].child1 == sibling)
+            nodes[oldParent].child1 = newParent;
+        else
+            nodes[oldParent].child2 = newParent;
+    }
+    else
+    {
+        root = newParent;
+    }
+
+    // walking back up the tree fixing heights and boxes
+    index = nodes[leaf].parent;
+    while (index != nullNode)
+    {
+        index = Balance(index);
+
+        int child1 = nodes[index].child1;
+        int child2 = nodes[index].child2;
+        nodes[index].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+        nodes[index].box = nodes[child1].box.Combine(nodes[child2].box);
+
+        index = nodes[index].parent;
+    }
+}
+
+void AABBTree::RemoveLeaf(int leaf)
+{
+    if (leaf == root)
+    {
+        root = nullNode;
+        return;
+    }
+
+    int parent = nodes[leaf].parent;
+    int grandParent = nodes[parent].parent;
+    int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    if (grandParent != nullNode)
+    {
+        // the sibling takes place of the parent
+        if (nodes[grandParent].child1 == parent)
+            nodes[grandParent].child1 = sibling;
+        else
+            nodes[grandParent].child2 = sibling;
+        nodes[sibling].parent = grandParent;
+        FreeNode(parent);
+
+        int index = grandParent;
+        while (index != nullNode)
+        {
+            index = Balance(index);
+
+            int child1 = nodes[index].child1;
+            int child2 = nodes[index].child2;
+            nodes[index].box = nodes[child1].box.Combine(nodes[child2].box);
+            nodes[index].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+
+            index = nodes[index].parent;
+        }
+    }
+    else
+    {
+        root = sibling;
+        nodes[sibling].parent = nullNode;
+        FreeNode(parent);
+    }
+}
+
+int AABBTree::Balance(int iA)
+{
+    // A is the node, B and C are its children, F and G are children of C ( D and E of B );
+    // the higher child becomes the parent of A
+    TreeNode* A = &nodes[iA];
+    if (A->IsLeaf() || A->height < 2)
+        return iA;
+
+    int iB = A->child1;
+    int iC = A->child2;
+    TreeNode* B = &nodes[iB];
+    TreeNode* C = &nodes[iC];
+
+    int balance = C->height - B->height;
+
+    // rotate C up
+    if (balance > 1)
+    {
+        int iF = C->child1;
+        int iG = C->child2;
+        TreeNode* F = &nodes[iF];
+        TreeNode* G = &nodes[iG];
+
+        C->child1 = iA;
+        C->parent = A->parent;
+        A->parent = iC;
+
+        if (C->parent != nullNode)
+        {
+            if (nodes[C->parent].child1 == iA)
+                nodes[C->parent].child1 = iC;
+            else
+                nodes[C->parent].child2 = iC;
+        }
+        else
+        {
+            root = iC;
+        }
+
+        if (F->height > G->height)
+        {
+            C->child2 = iF;
+            A->child2 = iG;
+            G->parent = iA;
+            A->box = B->box.Combine(G->box);
+            C->box = A->box.Combine(F->box);
+            A->height = 1 + std::max(B->height, G->height);
+            C->height = 1 + std::max(A->height, F->height);
+        }
+        else
+        {
+            C->child2 = iG;
+            A->child2 = iF;
+            F->parent = iA;
+            A->box = B->box.Combine(F->box);
+            C->box = A->box.Combine(G->box);
+            A->height = 1 + std::max(B->height, F->height);
+            C->height = 1 + std::max(A->height, G->height);
+        }
+
+        return iC;
+    }
+
+    // rotate B up
+    if (balance < -1)
+    {
+        int iD = B->child1;
+        int iE = B->child2;
+        TreeNode* D = &nodes[iD];
+        TreeNode* E = &nodes[iE];
+
+        B->child1 = iA;
+        B->parent = A->parent;
+        A->parent = iB;
+
+        if (B->parent != nullNode)
+        {
+            if (nodes[B->parent].child1 == iA)
+                nodes[B->parent].child1 = iB;
+            else
+                nodes[B->parent].child2 = iB;
+        }
+        else
+        {
+            root = iB;
+        }
+
+        if (D->height > E->height)
+        {
+            B->child2 = iD;
+            A->child1 = iE;
+            E->parent = iA;
+            A->box = C->box.Combine(E->box);
+            B->box = A->box.Combine(D->box);
+            A->height = 1 + std::max(C->height, E->height);
+            B->height = 1 + std::max(A->height, D->height);
+        }
+        else
+        {
+            B->child2 = iE;
+            A->child1 = iD;
+            D->parent = iA;
+            A->box = C->box.Combine(D->box);
+            B->box = A->box.Combine(E->box);
+            A->height = 1 + std::max(C->height, D->height);
+            B->height = 1 + std::max(A->height, E->height);
+        }
+
+        return iB;
+    }
+
+    return iA;
+}
+
+int AABBTree::BuildTopDown(int* first, int count)
+{
+    if (count == 1)
+        return first[0];
+
+    // leaves are split at the median of their centers along the longer side of centers bounds
+    AABB bounds(centers[first[0]], centers[first[0]]);
+    for (int i = 1; i < count; i++)
+    {
+        const Vector2D& center = centers[first[i]];
+        bounds.min.x = std::min(bounds.min.x, center.x);
+        bounds.min.y = std::min(bounds.min.y, center.y);
+        bounds.max.x = std::max(bounds.max.x, center.x);
+        bounds.max.y = std::max(bounds.max.y, center.y);
+    }
+
+    int half = count / 2;
+    if (bounds.max.x - bounds.min.x >= bounds.max.y - bounds.min.y)
+        std::nth_element(first, first + half, first + count, [&](int a, int b) { return centers[a].x < centers[b].x; });
+    else
+        std::nth_element(first, first + half, first + count, [&](int a, int b) { return centers[a].y < centers[b].y; });
+
+    int child1 = BuildTopDown(first, half);
+    int child2 = BuildTopDown(first + half, count - half);
+
+    int parent = AllocateNode();
+    nodes[parent].child1 = child1;
+    nodes[parent].child2 = child2;
+    nodes[parent].box = nodes[child1].box.Combine(nodes[child2].box);
+    nodes[parent].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+    nodes[child1].parent = parent;
+    nodes[child2].parent = parent;
+    return parent;
+}
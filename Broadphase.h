@@ -0,0 +1,188 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+class RigidBody;
+
+// index of an empty node
+const int nullNode = -1;
+
+// margin of boxes stored in the tree; a body moving inside its fat box doesn't change the tree
+const float aabbMargin = 0.2f;
+
+// max depth of the tree which can be queried
+const int maxTreeDepth = 256;
+
+
+// node of the tree - leaf holds one body, internal node holds union of its children
+struct TreeNode
+{
+    AABB box;
+    RigidBody* body;
+    int parent;     // next free node when node is not used
+    int child1;
+    int child2;
+    int height;     // 0 for leaves, -1 for free nodes
+
+    bool IsLeaf() const
+    {
+        return child1 == nullNode;
+    }
+};
+
+
+// AABBTree class - dynamic bounding volume hierarchy of bodies
+// bodies can be inserted one at a time, which keeps the tree balanced with rotations,
+// or the whole tree can be built at once top-down, which is much faster for many bodies
+class AABBTree
+{
+public:
+    // constructor
+    AABBTree();
+
+    // creates a leaf for the body and inserts it into the tree; returns index of the leaf
+    // box - tight box of the body; the tree keeps it enlarged by aabbMargin
+    // body - pointer to body which the leaf represents
+    int CreateProxy(const AABB& box, RigidBody* body);
+
+    // creates a leaf for the body without inserting it; the tree has to be rebuilt before querying
+    // box - tight box of the body
+    // body - pointer to body which the leaf represents
+    int CreateDetachedProxy(const AABB& box, RigidBody* body);
+
+    // removes the leaf from the tree
+    // proxy - index of the leaf
+    void DestroyProxy(int proxy);
+
+    // updates box of the leaf; the leaf is reinserted only when box leaves its fat box
+    // proxy - index of the leaf
+    // box - new tight box of the body
+    // returns whether the leaf was reinserted
+    bool MoveProxy(int proxy, const AABB& box);
+
+    // builds the whole tree again top-down from all leaves
+    void Rebuild();
+
+    // removes all leaves
+    void Clear();
+
+    // returns fat box of the leaf
+    const AABB& GetFatAABB(int proxy) const
+    {
+        return nodes[proxy].box;
+    }
+
+    // returns body of the leaf
+    RigidBody* GetBody(int proxy) const
+    {
+        return nodes[proxy].body;
+    }
+
+    // returns height of the tree
+    int GetHeight() const;
+
+    // calls callback(proxy) for every leaf whose fat box overlaps box; the query ends when callback returns false
+    // box - box to test
+    // callback - function called with index of each overlapping leaf
+    template<typename Callback>
+    void Query(const AABB& box, Callback callback) const
+    {
+        if (root == nullNode)
+            return;
+
+        int stack[maxTreeDepth];
+        int count = 0;
+        stack[count++] = root;
+
+        while (count > 0)
+        {
+            int index = stack[--count];
+            const TreeNode& node = nodes[index];
+            if (!node.box.Overlaps(box))
+                continue;
+
+            if (node.IsLeaf())
+            {
+                if (!callback(index))
+                    return;
+            }
+            else
+            {
+                assert(count + 2 <= maxTreeDepth);
+                stack[count++] = node.child1;
+                stack[count++] = node.child2;
+            }
+        }
+    }
+
+    // calls callback(proxy, maxFraction) for every leaf whose fat box is crossed by segment start + t * (end - start),
+    // t in [ 0, maxFraction ]; callback returns new maxFraction, which shortens the segment, or 0 to end the cast
+    // start - beginning of the segment
+    // end - end of the segment
+    // callback - function called with index of each crossed leaf
+    template<typename Callback>
+    void RayCast(const Vector2D& start, const Vector2D& end, Callback callback) const
+    {
+        if (root == nullNode)
+            return;
+
+        Vector2D delta = end - start;
+        float maxFraction = 1.0f;
+
+        int stack[maxTreeDepth];
+        int count = 0;
+        stack[count++] = root;
+
+        while (count > 0)
+        {
+            int index = stack[--count];
+            const TreeNode& node = nodes[index];
+            if (!node.box.IntersectsSegment(start, delta, maxFraction))
+                continue;
+
+            if (node.IsLeaf())
+            {
+                float value = callback(index, maxFraction);
+                if (value <= 0.0f)
+                    return;
+                maxFraction = std::min(maxFraction, value);
+            }
+            else
+            {
+                assert(count + 2 <= maxTreeDepth);
+                stack[count++] = node.child1;
+                stack[count++] = node.child2;
+            }
+        }
+    }
+
+private:
+    std::vector<TreeNode> nodes;
+    int root;
+    int freeList;
+    std::vector<int> leaves;
+    std::vector<Vector2D> centers;
+
+    // returns index of an unused node
+    int AllocateNode();
+
+    // returns node to the free list
+    void FreeNode(int node);
+
+    // inserts leaf next to the sibling which enlarges the tree the least
+    void InsertLeaf(int leaf);
+
+    // removes leaf and its parent from the tree
+    void RemoveLeaf(int leaf);
+
+    // rotates subtree if it is imbalanced; returns index of new subtree root
+    int Balance(int node);
+
+    // builds subtree from leaves by splitting them in half along the longer axis of their centers; returns index of subtree root
+    int BuildTopDown(int* first, int count);
+};
+
+#endif // BROADPHASE_H
@@ -0,0 +1,175 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#ifndef CAPSULE_H
+#define CAPSULE_H
+
+
+// Capsule class - segment with rounded ends, e.g. characters and rods
+// the core segment lies on the x axis of the capsule between ( -halfLength, 0 ) and ( halfLength, 0 ),
+// the surface is everything radius away from it, so collisions need only the nearest points of the core
+class Capsule : public Shape
+{
+public:
+    Matrix2X2 orientation;
+    float halfLength;
+    float radius;
+
+    // constructor
+    // _halfLength - half of the length of the core segment; greater than zero
+    // _radius - radius of rounded ends
+    Capsule(float _halfLength, float _radius)
+    {
+        assert(_halfLength > EPSILON);
+        halfLength = _halfLength;
+        radius = _radius;
+    }
+
+    Shape* Copy() const
+    {
+        Capsule* capsule = new Capsule(halfLength, radius);
+        capsule->orientation = orientation;
+        return capsule;
+    }
+
+    void Calculate(float density)
+    {
+        // the box between ends and two half circles which together make a circle
+        float length = 2.0f * halfLength;
+        float circleMass = PI * radius * radius * density;
+        float boxMass = 2.0f * radius * length * density;
+        body->mass = circleMass + boxMass;
+        if (body->mass == 0)
+            body->inverseMass = 0;
+        else
+            body->inverseMass = 1.0 / body->mass;
+
+        // centroid of a half circle is 4 * r / ( 3 * PI ) from its flat side, so by the parallel axis theorem
+        // each half moves by ( halfLength + centroid )^2 - centroid^2
+        float centroid = 4.0f * radius / (3.0f * PI);
+        float circleInertia = circleMass * (0.5f * radius * radius + halfLength * halfLength + 2.0f * halfLength * centroid);
+        float boxInertia = boxMass * (4.0f * radius * radius + length * length) / 12.0f;
+        body->inertialMoment = circleInertia + boxInertia;
+        if (body->inertialMoment == 0)
+            body->inverseInertialMoment = 0;
+        else
+            body->inverseInertialMoment = 1.0 / body->inertialMoment;
+    }
+
+    void SetOrientation(float radians)
+    {
+        orientation = Matrix2X2(radians);
+    }
+
+    AABB GetAABB() const
+    {
+        Vector2D a, b;
+        GetCore(a, b);
+        return AABB(Vector2D(std::min(a.x, b.x) - radius, std::min(a.y, b.y) - radius),
+                    Vector2D(std::max(a.x, b.x) + radius, std::max(a.y, b.y) + radius));
+    }
+
+    bool RayCast(const Vector2D& start, const Vector2D& delta, float maxFraction, float& fraction, Vector2D& normal) const
+    {
+        // the capsule is a box between its ends and two circles; the first entry into any of them is the entry into the capsule,
+        // and the box is entered only through its long sides, because its short sides are inside the circles
+        if (Contains(start))
+            return false;
+
+        Matrix2X2 inverse = orientation.transpose();
+        Vector2D localStart = inverse * (start - body->position);
+        Vector2D localDelta = inverse * delta;
+
+        float best = maxFraction;
+        bool hit = false;
+        Vector2D localNormal;
+
+        if (std::abs(localStart.y) > radius && localStart.y * localDelta.y < 0.0f)
+        {
+            float side = localStart.y > 0.0f ? radius : -radius;
+            float t = (side - localStart.y) / localDelta.y;
+            float x = localStart.x + t * localDelta.x;
+            if (t >= 0.0f && t <= best && x >= -halfLength && x <= halfLength)
+            {
+                best = t;
+                hit = true;
+                localNormal = Vector2D(0.0f, side > 0.0f ? 1.0f : -1.0f);
+            }
+        }
+
+        float a = localDelta.lengthPower2();
+        for (int end = -1; end <= 1 && a > FLT_EPSILON; end += 2)
+        {
+            // | m + t * delta | = radius
+            Vector2D m = localStart - Vector2D(end * halfLength, 0.0f);
+            float b = dot(m, localDelta);
+            float c = m.lengthPower2() - radius * radius;
+            float h = b * b - a * c;
+            if (c <= 0.0f || b > 0.0f || h < 0.0f)
+                continue;
+
+            float t = (-b - std::sqrt(h)) / a;
+            if (t < 0.0f || t > best)
+                continue;
+
+            best = t;
+            hit = true;
+            localNormal = (m + localDelta * t) * (1.0f / radius);
+        }
+
+        if (!hit)
+            return false;
+
+        fraction = best;
+        normal = orientation * localNormal;
+        return true;
+    }
+
+    bool Contains(const Vector2D& point) const
+    {
+        Vector2D local = orientation.transpose() * (point - body->position);
+        local.x -= std::min(halfLength, std::max(-halfLength, local.x));
+        return local.lengthPower2() <= radius * radius;
+    }
+
+    void Draw() const
+    {
+        DrawAt(body->position, body->orientation, body->bodyColor);
+    }
+
+    void DrawAt(const Vector2D& position, float radians, const Color& color) const
+    {
+        // half of the points of a circle go around each end
+        Matrix2X2 rotation(radians);
+        glColor3f(color.red, color.green, color.blue);
+        glBegin(GL_POLYGON);
+        for (int end = 1; end >= -1; end -= 2)
+        {
+            float theta = end > 0 ? -0.5f * PI : 0.5f * PI;
+            for (int i = 0; i <= circlePoints / 2; i++, theta += PI / (circlePoints / 2))
+            {
+                Vector2D v = position + rotation * Vector2D(end * halfLength + radius * std::cos(theta), radius * std::sin(theta));
+                glVertex2f(v.x, v.y);
+            }
+        }
+        glEnd();
+    }
+
+    int GetType() const
+    {
+        return CapsuleID;
+    }
+
+    // writes ends of the core segment in coordinates of the world
+    // a - end on the negative side of the x axis of the capsule
+    // b - end on the positive side
+    void GetCore(Vector2D& a, Vector2D& b) const
+    {
+        Vector2D axis = orientation * Vector2D(halfLength, 0.0f);
+        a = body->position - axis;
+        b = body->position + axis;
+    }
+};
+
+#endif // CAPSULE_H
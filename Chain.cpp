@@ -0,0 +1,308 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#include "IncludesManager.h"
+
+// returns distance of point from box; 0 inside
+static float DistanceToBox(const Vector2D& point, const AABB& box)
+{
+    float dx = std::max(0.0f, std::max(box.min.x - point.x, point.x - box.max.x));
+    float dy = std::max(0.0f, std::max(box.min.y - point.y, point.y - box.max.y));
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+
+Chain::Chain()
+{
+    loop = false;
+    root = nullNode;
+}
+
+Chain::Chain(const Vector2D* _vertices, int _count, bool _loop)
+{
+    assert(_count >= (_loop ? 3 : 4));
+    vertices.assign(_vertices, _vertices + _count);
+    loop = _loop;
+    Build();
+}
+
+Shape* Chain::Copy() const
+{
+    Chain* chain = new Chain();
+    chain->orientation = orientation;
+    chain->vertices = vertices;
+    chain->normals = normals;
+    chain->loop = loop;
+    chain->nodes = nodes;
+    chain->root = root;
+    chain->bounds = bounds;
+    return chain;
+}
+
+void Chain::Calculate(float density)
+{
+    body->mass = 0.0f;
+    body->inverseMass = 0.0f;
+    body->inertialMoment = 0.0f;
+    body->inverseInertialMoment = 0.0f;
+}
+
+void Chain::SetOrientation(float radians)
+{
+    orientation = Matrix2X2(radians);
+}
+
+AABB Chain::GetAABB() const
+{
+    // corners of the box of all vertices are turned instead of the vertices, so it costs the same for any length;
+    // the box of the tree isn't enough, because it leaves out the first and last segments of an open chain
+    const AABB& local = bounds;
+    Vector2D corners[4] = { local.min, Vector2D(local.max.x, local.min.y), local.max, Vector2D(local.min.x, local.max.y) };
+    Vector2D v = orientation * corners[0];
+    AABB box(v, v);
+    for (int i = 1; i < 4; i++)
+    {
+        v = orientation * corners[i];
+        box.min.x = std::min(box.min.x, v.x);
+        box.min.y = std::min(box.min.y, v.y);
+        box.max.x = std::max(box.max.x, v.x);
+        box.max.y = std::max(box.max.y, v.y);
+    }
+    box.min += body->position;
+    box.max += body->position;
+    return box;
+}
+
+bool Chain::RayCast(const Vector2D& start, const Vector2D& delta, float maxFraction, float& fraction, Vector2D& normal) const
+{
+    Matrix2X2 inverse = orientation.transpose();
+    Vector2D localStart = inverse * (start - body->position);
+    Vector2D localDelta = inverse * delta;
+
+    int hit = -1;
+    float upper = maxFraction;
+    if (root == nullNode)
+        return false;
+
+    int stack[maxChainDepth];
+    int count = 0;
+    stack[count++] = root;
+    while (count > 0)
+    {
+        const ChainNode& node = nodes[stack[--count]];
+        if (!node.box.IntersectsSegment(localStart, localDelta, upper))
+            continue;
+
+        if (node.child1 != nullNode)
+        {
+            assert(count + 2 <= maxChainDepth);
+            stack[count++] = node.child1;
+            stack[count++] = node.child2;
+            continue;
+        }
+
+        // start + t * delta = a + u * edge
+        int segment = node.child2;
+        const Vector2D& a = vertices[segment];
+        Vector2D edge = vertices[(segment + 1) % vertices.size()] - a;
+        float denominator = cross(localDelta, edge);
+        if (std::abs(denominator) < FLT_EPSILON)
+            continue;
+
+        float t = cross(a - localStart, edge) / denominator;
+        float u = cross(a - localStart, localDelta) / denominator;
+        if (t < 0.0f || t > upper || u < 0.0f || u > 1.0f)
+            continue;
+
+        upper = t;
+        hit = segment;
+    }
+
+    if (hit < 0)
+        return false;
+
+    fraction = upper;
+    normal = dot(normals[hit], localDelta) > 0.0f ? -normals[hit] : normals[hit];
+    normal = orientation * normal;
+    return true;
+}
+
+bool Chain::Contains(const Vector2D& point) const
+{
+    return false;
+}
+
+void Chain::Draw() const
+{
+    DrawAt(body->position, body->orientation, body->bodyColor);
+}
+
+void Chain::DrawAt(const Vector2D& position, float radians, const Color& color) const
+{
+    Matrix2X2 rotation(radians);
+    glColor3f(color.red, color.green, color.blue);
+    glBegin(loop ? GL_LINE_LOOP : GL_LINE_STRIP);
+    for (unsigned int i = 0; i < vertices.size(); i++)
+    {
+        Vector2D v = position + rotation * vertices[i];
+        glVertex2f(v.x, v.y);
+    }
+    glEnd();
+}
+
+int Chain::GetType() const
+{
+    return ChainID;
+}
+
+int Chain::SegmentCount() const
+{
+    return loop ? (int)vertices.size() : (int)vertices.size() - 1;
+}
+
+ChainSegment Chain::GetSegment(int index) const
+{
+    // colliding segments of open chains have both neighbours, so indices only wrap around loops
+    int count = (int)vertices.size();
+    ChainSegment segment;
+    segment.ghost1 = body->position + orientation * vertices[(index + count - 1) % count];
+    segment.a = body->position + orientation * vertices[index];
+    segment.b = body->position + orientation * vertices[(index + 1) % count];
+    segment.ghost2 = body->position + orientation * vertices[(index + 2) % count];
+    segment.normal = orientation * normals[index];
+    return segment;
+}
+
+AABB Chain::ToLocal(const AABB& box) const
+{
+    Matrix2X2 inverse = orientation.transpose();
+    Vector2D corners[4] = { box.min, Vector2D(box.max.x, box.min.y), box.max, Vector2D(box.min.x, box.max.y) };
+    Vector2D v = inverse * (corners[0] - body->position);
+    AABB local(v, v);
+    for (int i = 1; i < 4; i++)
+    {
+        v = inverse * (corners[i] - body->position);
+        local.min.x = std::min(local.min.x, v.x);
+        local.min.y = std::min(local.min.y, v.y);
+        local.max.x = std::max(local.max.x, v.x);
+        local.max.y = std::max(local.max.y, v.y);
+    }
+    return local;
+}
+
+Chain* Chain::FromStored(const Vector2D* _vertices, int _count, bool _loop)
+{
+    if (_count < (_loop ? 3 : 4))
+        return nullptr;
+
+    // segments of zero length have no normal
+    int segments = _loop ? _count : _count - 1;
+    for (int i = 0; i < segments; i++)
+        if ((_vertices[(i + 1) % _count] - _vertices[i]).lengthPower2() <= EPSILON * EPSILON)
+            return nullptr;
+    return new Chain(_vertices, _count, _loop);
+}
+
+float Chain::Distance(const Vector2D& point) const
+{
+    Vector2D local = orientation.transpose() * (point - body->position);
+    float best = FLT_MAX;
+    if (root == nullNode)
+        return best;
+
+    // subtrees further than the nearest segment found so far are skipped
+    int stack[maxChainDepth];
+    int count = 0;
+    stack[count++] = root;
+    while (count > 0)
+    {
+        const ChainNode& node = nodes[stack[--count]];
+        if (DistanceToBox(local, node.box) >= best)
+            continue;
+
+        if (node.child1 == nullNode)
+        {
+            int segment = node.child2;
+            best = std::min(best, DistanceToSegment(local, vertices[segment], vertices[(segment + 1) % vertices.size()]));
+        }
+        else
+        {
+            assert(count + 2 <= maxChainDepth);
+            stack[count++] = node.child1;
+            stack[count++] = node.child2;
+        }
+    }
+    return best;
+}
+
+void Chain::Build()
+{
+    int count = (int)vertices.size();
+    int segments = SegmentCount();
+    normals.resize(count);
+    for (int i = 0; i < count; i++)
+        normals[i] = Vector2D(0.0f, 0.0f);
+
+    bounds = AABB(vertices[0], vertices[0]);
+    for (int i = 1; i < count; i++)
+        bounds = bounds.Combine(AABB(vertices[i], vertices[i]));
+
+    std::vector<int> colliding;
+    std::vector<Vector2D> centers(segments);
+    for (int i = 0; i < segments; i++)
+    {
+        Vector2D face = vertices[(i + 1) % count] - vertices[i];
+        assert(face.lengthPower2() > EPSILON * EPSILON);
+        normals[i] = Vector2D(face.y, -face.x);
+        normals[i].normalize();
+        centers[i] = (vertices[i] + vertices[(i + 1) % count]) * 0.5f;
+
+        if (loop || (i > 0 && i < segments - 1))
+            colliding.push_back(i);
+    }
+
+    // an open chain shorter than four vertices has only ghost segments, so nothing collides with it
+    nodes.clear();
+    root = nullNode;
+    if (colliding.empty())
+        return;
+    nodes.reserve(2 * colliding.size() - 1);
+    root = BuildTopDown(colliding.data(), (int)colliding.size(), centers);
+}
+
+int Chain::BuildTopDown(int* first, int count, const std::vector<Vector2D>& centers)
+{
+    if (count == 1)
+    {
+        const Vector2D& a = vertices[first[0]];
+        const Vector2D& b = vertices[(first[0] + 1) % vertices.size()];
+        ChainNode leaf;
+        leaf.box = AABB(Vector2D(std::min(a.x, b.x), std::min(a.y, b.y)), Vector2D(std::max(a.x, b.x), std::max(a.y, b.y)));
+        leaf.child1 = nullNode;
+        leaf.child2 = first[0];
+        nodes.push_back(leaf);
+        return (int)nodes.size() - 1;
+    }
+
+    // segments are split at the median of their centers along the longer side of centers bounds
+    AABB bounds(centers[first[0]], centers[first[0]]);
+    for (int i = 1; i < count; i++)
+        bounds = bounds.Combine(AABB(centers[first[i]], centers[first[i]]));
+
+    int half = count / 2;
+    if (bounds.max.x - bounds.min.x >= bounds.max.y - bounds.min.y)
+        std::nth_element(first, first + half, first + count, [&](int a, int b) { return centers[a].x < centers[b].x; });
+    else
+        std::nth_element(first, first + half, first + count, [&](int a, int b) { return centers[a].y < centers[b].y; });
+
+    int child1 = BuildTopDown(first, half, centers);
+    int child2 = BuildTopDown(first + half, count - half, centers);
+
+    ChainNode parent;
+    parent.box = nodes[child1].box.Combine(nodes[child2].box);
+    parent.child1 = child1;
+    parent.child2 = child2;
+    nodes.push_back(parent);
+    return (int)nodes.size() - 1;
+}
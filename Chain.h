@@ -0,0 +1,147 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#ifndef CHAIN_H
+#define CHAIN_H
+
+// max depth of the tree of segments which can be queried
+const int maxChainDepth = 64;
+
+// width of drawn chains in [ pixel ]
+const float chainLineWidth = 2.0f;
+
+
+// node of the tree of segments - leaf holds one segment, internal node holds union of its children
+struct ChainNode
+{
+    AABB box;           // in coordinates of the chain
+    int child1;         // nullNode for leaves
+    int child2;         // index of the segment for leaves
+};
+
+
+// segment of a chain in coordinates of the world together with its neighbouring ( ghost ) vertices
+struct ChainSegment
+{
+    Vector2D ghost1;    // vertex before a
+    Vector2D a;
+    Vector2D b;
+    Vector2D ghost2;    // vertex after b
+    Vector2D normal;    // normal of the front side
+};
+
+
+// Chain class - static polyline of segments, e.g. terrain
+// segment i goes from vertex i to vertex i + 1 and collides only on its front side, which is on the right
+// of its direction like outer sides of Poly faces, so a loop wound like a polygon keeps bodies outside;
+// vertices next to a segment are its ghost vertices, which tell how the chain continues behind its ends,
+// so bodies sliding over seams get the normal of the surface instead of catching on inner corners
+// a loop collides on all its segments; an open chain doesn't collide on its first and last segment,
+// whose outer vertices only serve as ghosts of their neighbours
+// segments are kept in their own tree, so a body touching the chain tests only segments near it
+class Chain : public Shape
+{
+public:
+    Matrix2X2 orientation;
+    std::vector<Vector2D> vertices;     // in coordinates of the chain
+    std::vector<Vector2D> normals;      // normal of the front side of every segment
+    bool loop;
+
+    // virtual constructor
+    Chain();
+
+    // constructor
+    // _vertices - vertices in order along the chain, relative to position of the body
+    // _count - number of vertices; at least 3 for loops and 4 for open chains
+    // _loop - whether the last vertex is connected with the first one
+    Chain(const Vector2D* _vertices, int _count, bool _loop);
+
+    Shape* Copy() const;
+
+    // chains are always static, so density is ignored
+    void Calculate(float density);
+
+    void SetOrientation(float radians);
+
+    AABB GetAABB() const;
+
+    // segments are hit from both sides; the normal faces the start of the ray
+    bool RayCast(const Vector2D& start, const Vector2D& delta, float maxFraction, float& fraction, Vector2D& normal) const;
+
+    // chains have no inside
+    bool Contains(const Vector2D& point) const;
+
+    void Draw() const;
+
+    void DrawAt(const Vector2D& position, float radians, const Color& color) const;
+
+    int GetType() const;
+
+    // returns number of segments, including the not colliding ones of open chains
+    int SegmentCount() const;
+
+    // returns a colliding segment with its ghost vertices in coordinates of the world
+    // index - index of the segment given by Query
+    ChainSegment GetSegment(int index) const;
+
+    // returns box in coordinates of the chain which contains given box of the world
+    // box - box in coordinates of the world
+    AABB ToLocal(const AABB& box) const;
+
+    // creates chain from vertices written to a file; returns nullptr if they don't make a chain
+    // _vertices - vertices of the chain
+    // _count - number of vertices
+    // _loop - the stored loop flag; it isn't guessed from vertices, because an open chain may end where it starts
+    static Chain* FromStored(const Vector2D* _vertices, int _count, bool _loop);
+
+    // returns distance of point from the nearest colliding segment; FLT_MAX if no segment collides
+    // point - point in coordinates of the world
+    float Distance(const Vector2D& point) const;
+
+    // calls callback(segment) for every colliding segment whose box overlaps box; the query ends when callback returns false
+    // box - box in coordinates of the chain, e.g. from ToLocal
+    // callback - function called with index of each overlapping segment
+    template<typename Callback>
+    void Query(const AABB& box, Callback callback) const
+    {
+        if (root == nullNode)
+            return;
+
+        int stack[maxChainDepth];
+        int count = 0;
+        stack[count++] = root;
+
+        while (count > 0)
+        {
+            const ChainNode& node = nodes[stack[--count]];
+            if (!node.box.Overlaps(box))
+                continue;
+
+            if (node.child1 == nullNode)
+            {
+                if (!callback(node.child2))
+                    return;
+            }
+            else
+            {
+                assert(count + 2 <= maxChainDepth);
+                stack[count++] = node.child1;
+                stack[count++] = node.child2;
+            }
+        }
+    }
+
+private:
+    std::vector<ChainNode> nodes;
+    int root;           // nullNode when no segment collides
+    AABB bounds;        // box of all vertices in coordinates of the chain
+
+    // calculates normals and builds the tree of colliding segments
+    void Build();
+
+    // builds subtree from segments by splitting them in half along the longer axis of their centers; returns index of subtree root
+    int BuildTopDown(int* first, int count, const std::vector<Vector2D>& centers);
+};
+
+#endif // CHAIN_H
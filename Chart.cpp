@@ -0,0 +1,218 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#include "IncludesManager.h"
+
+// phases drawn as stacked bars; PhaseStep is their sum, and commands, sensors and events are small enough to skip
+static const ProfilePhase chartPhases[] = {
+    PhaseBroadphase, PhasePairs, PhaseNarrowphase, PhasePrepareContacts,
+    PhaseIntegrateForces, PhaseSolve, PhaseIntegrateVelocities, PhaseCorrectPositions
+};
+static const unsigned int chartPhaseCount = sizeof(chartPhases) / sizeof(chartPhases[0]);
+
+static const Color chartColors[chartPhaseCount] = {
+    { 0.90f, 0.30f, 0.25f }, { 0.95f, 0.60f, 0.20f }, { 0.95f, 0.85f, 0.25f }, { 0.55f, 0.80f, 0.30f },
+    { 0.30f, 0.75f, 0.70f }, { 0.30f, 0.55f, 0.90f }, { 0.60f, 0.40f, 0.85f }, { 0.85f, 0.45f, 0.70f }
+};
+
+// budget of one frame at 60 Hz in [ millisecond ]
+const float chartBudget = 1000.0f / 60.0f;
+
+// size of the overlay in pixels
+const float chartWidth = 300.0f;
+const float chartHeight = 90.0f;
+const float chartMargin = 10.0f;
+
+
+ChartRing::ChartRing()
+{
+    head = 0;
+    tail = 0;
+}
+
+bool ChartRing::Push(const ChartSample& sample)
+{
+    unsigned int h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) == chartRingSize)
+        return false;
+
+    samples[h % chartRingSize] = sample;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+bool ChartRing::Pop(ChartSample& sample)
+{
+    unsigned int t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire))
+        return false;
+
+    sample = samples[t % chartRingSize];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+
+// draws text at given position in pixels
+static void DrawText(float x, float y, const char* text)
+{
+    glRasterPos2f(x, y);
+    for (const char* c = text; *c; c++)
+        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_10, *c);
+}
+
+// draws frame of a graph
+static void DrawFrame(float x, float y)
+{
+    glColor4f(0.0f, 0.0f, 0.0f, 0.6f);
+    glBegin(GL_QUADS);
+    glVertex2f(x, y);
+    glVertex2f(x + chartWidth, y);
+    glVertex2f(x + chartWidth, y + chartHeight);
+    glVertex2f(x, y + chartHeight);
+    glEnd();
+}
+
+
+PerformanceChart::PerformanceChart()
+{
+    visible = true;
+    next = 0;
+    count = 0;
+}
+
+void PerformanceChart::Push(const World& world)
+{
+    // without the profiler only counts of contacts and bodies are drawn
+    ChartSample sample;
+    for (int i = 0; i < PhaseCount; i++)
+    {
+#if defined(RIGIDBODY_PROFILE)
+        sample.phases[i] = world.profiler.GetLast((ProfilePhase)i);
+#else
+        sample.phases[i] = 0.0f;
+#endif
+    }
+    sample.contacts = (unsigned int)world.contacts.size();
+    sample.bodies = (unsigned int)world.bodies.size();
+
+    // a full ring means nobody draws, so the sample isn't needed
+    ring.Push(sample);
+}
+
+void PerformanceChart::Toggle()
+{
+    visible = !visible;
+}
+
+bool PerformanceChart::IsVisible() const
+{
+    return visible;
+}
+
+const ChartSample& PerformanceChart::GetSample(unsigned int back) const
+{
+    return history[(next + chartHistory - 1 - back) % chartHistory];
+}
+
+void PerformanceChart::Draw()
+{
+    // the ring is drained even when the overlay is hidden, so the simulation keeps pushing
+    ChartSample sample;
+    while (ring.Pop(sample))
+    {
+        history[next] = sample;
+        next = (next + 1) % chartHistory;
+        if (count < chartHistory)
+            count++;
+    }
+
+    if (!visible || count == 0)
+        return;
+
+    // the overlay is drawn in pixels on top of whatever projection the scene uses
+    int width = glutGet(GLUT_WINDOW_WIDTH);
+    int height = glutGet(GLUT_WINDOW_HEIGHT);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    gluOrtho2D(0, width, height, 0);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+    glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    float step = chartWidth / chartHistory;
+    char text[64];
+
+    // phase times - stacked bars, the oldest step on the left; the scale fits twice the frame budget
+    float x = chartMargin;
+    float y = chartMargin;
+    DrawFrame(x, y);
+    float scale = chartHeight / (2.0f * chartBudget);
+    glBegin(GL_QUADS);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        const ChartSample& s = GetSample(i);
+        float left = x + chartWidth - (i + 1) * step;
+        float bottom = y + chartHeight;
+        for (unsigned int p = 0; p < chartPhaseCount && bottom > y; p++)
+        {
+            float top = std::max(bottom - s.phases[chartPhases[p]] * scale, y);
+            glColor3f(chartColors[p].red, chartColors[p].green, chartColors[p].blue);
+            glVertex2f(left, bottom);
+            glVertex2f(left + step, bottom);
+            glVertex2f(left + step, top);
+            glVertex2f(left, top);
+            bottom = top;
+        }
+    }
+    glEnd();
+
+    glColor3f(1.0f, 1.0f, 1.0f);
+    glBegin(GL_LINES);
+    glVertex2f(x, y + chartHeight - chartBudget * scale);
+    glVertex2f(x + chartWidth, y + chartHeight - chartBudget * scale);
+    glEnd();
+
+    snprintf(text, sizeof(text), "step %.2f ms", GetSample(0).phases[PhaseStep]);
+    DrawText(x + 4.0f, y + 12.0f, text);
+    for (unsigned int p = 0; p < chartPhaseCount; p++)
+    {
+        glColor3f(chartColors[p].red, chartColors[p].green, chartColors[p].blue);
+        DrawText(x + chartWidth + 6.0f, y + 10.0f + 10.0f * p, Profiler::GetName(chartPhases[p]));
+    }
+
+    // contacts and bodies - lines scaled to the largest value in the history
+    y += chartHeight + chartMargin;
+    DrawFrame(x, y);
+    unsigned int largest = 1;
+    for (unsigned int i = 0; i < count; i++)
+        largest = std::max(largest, std::max(GetSample(i).contacts, GetSample(i).bodies));
+    scale = chartHeight / largest;
+
+    glColor3f(1.0f, 0.5f, 0.2f);
+    glBegin(GL_LINE_STRIP);
+    for (unsigned int i = 0; i < count; i++)
+        glVertex2f(x + chartWidth - (i + 0.5f) * step, y + chartHeight - GetSample(i).contacts * scale);
+    glEnd();
+    snprintf(text, sizeof(text), "contacts %u", GetSample(0).contacts);
+    DrawText(x + 4.0f, y + 12.0f, text);
+
+    glColor3f(0.3f, 0.8f, 1.0f);
+    glBegin(GL_LINE_STRIP);
+    for (unsigned int i = 0; i < count; i++)
+        glVertex2f(x + chartWidth - (i + 0.5f) * step, y + chartHeight - GetSample(i).bodies * scale);
+    glEnd();
+    snprintf(text, sizeof(text), "bodies %u", GetSample(0).bodies);
+    DrawText(x + 4.0f, y + 24.0f, text);
+
+    glPopAttrib();
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+}
@@ -1,77 +1,84 @@
 /*
 * Copyright (c) 2021 Karol Janic
 */
-/*
+
 #ifndef CHART_H
 #define CHART_H
 
-//#include "IncludesManager.h"
+class World;
 
-// mouse moves definition
-void mouse(int button, int state, int x, int y)
-{
-    if (state == GLUT_DOWN)
-        switch (button)
-        {
-        case GLUT_LEFT_BUTTON:
-        {
-         
-        }
-        break;
-        case GLUT_RIGHT_BUTTON:
-        {
-            
-        }
-        break;
-        }
-}
-
-// keyboard moves definition
-void keyboard(unsigned char key, int x, int y)
+// number of samples which fit in the ring between the simulation and the renderer
+const unsigned int chartRingSize = 256;
+
+// number of last steps drawn by the chart
+const unsigned int chartHistory = 300;
+
+
+// statistics of one step shown by the chart
+struct ChartSample
 {
-    switch (key)
-    {
-    case 27:
-        exit(0);
-        break;
-    }
-}
-
-void loop()
+    float phases[PhaseCount];       // in [ millisecond ]
+    unsigned int contacts;
+    unsigned int bodies;
+};
+
+
+// ChartRing class - lock-free ring with one producing and one consuming thread
+// the producer never waits: when the consumer falls behind, new samples are dropped
+class ChartRing
 {
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+public:
+    // constructor
+    ChartRing();
+
+    // adds a sample; returns false if the ring is full; called only by the producing thread
+    // sample - sample to add
+    bool Push(const ChartSample& sample);
 
-    glutSwapBuffers();
-}
+    // takes the oldest sample; returns false if the ring is empty; called only by the consuming thread
+    // sample - filled with taken sample
+    bool Pop(ChartSample& sample);
 
+private:
+    ChartSample samples[chartRingSize];
+    std::atomic<unsigned int> head;     // number of pushed samples
+    std::atomic<unsigned int> tail;     // number of taken samples
+};
 
-// Fancy World - an empty stage on which we can freely create polygons and circles
-void test(int argc, char** argv)
+
+// PerformanceChart class - overlay with rolling graphs of phase times, contact count and body count
+// the simulating thread pushes statistics after every step and the rendering thread draws
+// everything which arrived since the last frame, so drawing never waits for the simulation
+class PerformanceChart
 {
-    
+public:
+    // constructor
+    PerformanceChart();
+
+    // pushes statistics of the last step; called by the thread which steps the world
+    // world - stepped world
+    void Push(const World& world);
+
+    // draws the overlay on top of the frame; called by the rendering thread
+    void Draw();
 
+    // shows or hides the overlay
+    void Toggle();
 
+    // checks whether the overlay is shown
+    bool IsVisible() const;
 
-    glutInit(&argc, argv);
-    glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE);
-    glutInitWindowSize(800, 600);
-    glutCreateWindow("Rigid Body 2D Simulator: Fancy World");
-    glutDisplayFunc(loop);
-    glutKeyboardFunc(keyboard);
-    glutMouseFunc(mouse);
-    glutIdleFunc(loop);
+private:
+    ChartRing ring;
+    std::atomic<bool> visible;
 
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    glLoadIdentity();
-    gluOrtho2D(0, 80, 60, 0);
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
+    // last samples of the rendering thread
+    ChartSample history[chartHistory];
+    unsigned int next;
+    unsigned int count;
 
- 
-    glutMainLoop();
-}
+    // returns sample which is back steps older than the newest one
+    const ChartSample& GetSample(unsigned int back) const;
+};
 
-#endif //CHART_H
-*/
\ No newline at end of file
+#endif // CHART_H
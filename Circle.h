@@ -40,11 +40,53 @@ public:
         // rotate of circle isn't relevant
     }
 
+    AABB GetAABB() const
+    {
+        return AABB(Vector2D(body->position.x - radius, body->position.y - radius),
+                    Vector2D(body->position.x + radius, body->position.y + radius));
+    }
+
+    bool RayCast(const Vector2D& start, const Vector2D& delta, float maxFraction, float& fraction, Vector2D& normal) const
+    {
+        // | start + s * direction - position | = radius; the distance of the center from the line is taken
+        // from the perpendicular part of m, which stays precise for starts far from the circle
+        Vector2D m = start - body->position;
+        float length = delta.length();
+        if (m.lengthPower2() <= radius * radius || length < FLT_EPSILON)
+            return false;
+
+        Vector2D direction = delta * (1.0f / length);
+        float b = dot(m, direction);
+        Vector2D perpendicular = m - direction * b;
+        float h = radius * radius - perpendicular.lengthPower2();
+        if (b > 0.0f || h < 0.0f)
+            return false;
+
+        float t = (-b - std::sqrt(h)) / length;
+        if (t < 0.0f || t > maxFraction)
+            return false;
+
+        fraction = t;
+        normal = m + delta * t;
+        normal.normalize();
+        return true;
+    }
+
+    bool Contains(const Vector2D& point) const
+    {
+        return (point - body->position).lengthPower2() <= radius * radius;
+    }
+
     void Draw() const
     {
-        glColor3f(body->bodyColor.red, body->bodyColor.green, body->bodyColor.blue);
+        DrawAt(body->position, body->orientation, body->bodyColor);
+    }
+
+    void DrawAt(const Vector2D& position, float radians, const Color& color) const
+    {
+        glColor3f(color.red, color.green, color.blue);
         glBegin(GL_POLYGON);
-        float theta = body->orientation;
+        float theta = radians;
         float angle = PI * 2.0 / (float)circlePoints;
         Vector2D point;
         for (int i = 0; i < circlePoints; i++)
@@ -53,7 +95,7 @@ public:
             point.x = std::cos(theta);
             point.y = std::sin(theta);
             point *= radius;
-            point += body->position;
+            point += position;
             glVertex2f(point.x, point.y);
         }
         glEnd();
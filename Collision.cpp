@@ -128,6 +128,617 @@ void PolygonToCircle(ContactPoint* point, RigidBody* bodyA, RigidBody* bodyB)
     point->normal = -point->normal;
 }
 
+// sine of the largest angle between cores which are treated as parallel, so they touch along a line at two points
+const float capsuleParallelTolerance = 0.05f;
+
+// finds the nearest points of segments p1 - q1 and p2 - q2; returns square of their distance
+// c1, c2 - set to the nearest points on the first and the second segment
+static float ClosestPoints(const Vector2D& p1, const Vector2D& q1, const Vector2D& p2, const Vector2D& q2, Vector2D& c1, Vector2D& c2)
+{
+    // p1 + s * d1 and p2 + t * d2 with s and t clamped to [ 0, 1 ]
+    Vector2D d1 = q1 - p1;
+    Vector2D d2 = q2 - p2;
+    Vector2D r = p1 - p2;
+    float a = dot(d1, d1);
+    float e = dot(d2, d2);
+    float f = dot(d2, r);
+    float s = 0.0f;
+    float t = 0.0f;
+
+    if (a <= FLT_EPSILON && e > FLT_EPSILON)
+    {
+        t = std::min(1.0f, std::max(0.0f, f / e));
+    }
+    else if (a > FLT_EPSILON)
+    {
+        float c = dot(d1, r);
+        if (e <= FLT_EPSILON)
+        {
+            s = std::min(1.0f, std::max(0.0f, -c / a));
+        }
+        else
+        {
+            float b = dot(d1, d2);
+            float denominator = a * e - b * b;
+            s = denominator > 0.0f ? std::min(1.0f, std::max(0.0f, (b * f - c * e) / denominator)) : 0.0f;
+            t = (b * s + f) / e;
+            if (t < 0.0f)
+            {
+                t = 0.0f;
+                s = std::min(1.0f, std::max(0.0f, -c / a));
+            }
+            else if (t > 1.0f)
+            {
+                t = 1.0f;
+                s = std::min(1.0f, std::max(0.0f, (b - c) / a));
+            }
+        }
+    }
+
+    c1 = p1 + d1 * s;
+    c2 = p2 + d2 * t;
+    return (c2 - c1).lengthPower2();
+}
+
+// contacts of capsules lie halfway between both surfaces, so neither body is favoured by the solver
+void CapsuleToCircle(ContactPoint* point, RigidBody* bodyA, RigidBody* bodyB)
+{
+    const Capsule* A = (const Capsule*)(bodyA->shape);
+    const Circle* B = (const Circle*)(bodyB->shape);
+    point->contact_count = 0;
+
+    Vector2D a, b;
+    A->GetCore(a, b);
+    Vector2D edge = b - a;
+    float t = std::min(1.0f, std::max(0.0f, dot(bodyB->position - a, edge) / edge.lengthPower2()));
+    Vector2D closest = a + edge * t;
+
+    Vector2D normal = bodyB->position - closest;
+    float distancePower2 = normal.lengthPower2();
+    float radius = A->radius + B->radius;
+    if (distancePower2 >= radius * radius)
+        return;
+
+    float distance = std::sqrt(distancePower2);
+    if (distance > EPSILON)
+    {
+        normal = normal / distance;
+    }
+    else
+    {
+        normal = Vector2D(-edge.y, edge.x);
+        normal.normalize();
+    }
+
+    point->contact_count = 1;
+    point->normal = normal;
+    point->penetration = radius - distance;
+    point->contacts[0] = closest + normal * (0.5f * (A->radius + distance - B->radius));
+}
+
+void CircleToCapsule(ContactPoint* point, RigidBody* bodyA, RigidBody* bodyB)
+{
+    CapsuleToCircle(point, bodyB, bodyA);
+    point->normal = -point->normal;
+}
+
+void CapsuleToCapsule(ContactPoint* point, RigidBody* bodyA, RigidBody* bodyB)
+{
+    const Capsule* A = (const Capsule*)(bodyA->shape);
+    const Capsule* B = (const Capsule*)(bodyB->shape);
+    point->contact_count = 0;
+
+    Vector2D a1, b1, a2, b2;
+    A->GetCore(a1, b1);
+    B->GetCore(a2, b2);
+    Vector2D c1, c2;
+    float distancePower2 = ClosestPoints(a1, b1, a2, b2, c1, c2);
+    float radius = A->radius + B->radius;
+    if (distancePower2 >= radius * radius)
+        return;
+
+    Vector2D axis = b1 - a1;
+    axis.normalize();
+    Vector2D axisB = b2 - a2;
+    axisB.normalize();
+    Vector2D side(-axis.y, axis.x);
+    if (dot(side, bodyB->position - bodyA->position) < 0.0f)
+        side = -side;
+
+    // parallel cores lying on each other touch along a line, so the core of B is clipped to the ends of A
+    // and touches at both clipped points; one nearest point would jump between ends and let them rock
+    if (std::abs(cross(axis, axisB)) < capsuleParallelTolerance)
+    {
+        Vector2D incident[2] = { a2, b2 };
+        if (Clip(-axis, -dot(axis, a1), incident) == 2 && Clip(axis, dot(axis, b1), incident) == 2)
+        {
+            int cp = 0;
+            point->penetration = 0.0f;
+            for (int i = 0; i < 2; i++)
+            {
+                float separation = dot(side, incident[i] - a1) - radius;
+                if (separation <= 0.0f)
+                {
+                    point->contacts[cp++] = incident[i] - side * (B->radius + 0.5f * separation);
+                    point->penetration -= separation;
+                }
+            }
+            if (cp > 0)
+            {
+                point->penetration /= (float)cp;
+                point->normal = side;
+                point->contact_count = cp;
+                return;
+            }
+        }
+    }
+
+    float distance = std::sqrt(distancePower2);
+    point->contact_count = 1;
+    point->normal = distance > EPSILON ? (c2 - c1) / distance : side;
+    point->penetration = radius - distance;
+    point->contacts[0] = c1 + point->normal * (0.5f * (A->radius + distance - B->radius));
+}
+
+void CapsuleToPolygon(ContactPoint* point, RigidBody* bodyA, RigidBody* bodyB)
+{
+    const Capsule* A = (const Capsule*)(bodyA->shape);
+    const Poly* B = (const Poly*)(bodyB->shape);
+    float radius = A->radius;
+    point->contact_count = 0;
+
+    Vector2D a, b;
+    A->GetCore(a, b);
+    Vector2D vertices[MaxPolyVertexCount];
+    Vector2D faceNormals[MaxPolyVertexCount];
+    int count = B->verticesCount;
+    for (int i = 0; i < count; i++)
+    {
+        vertices[i] = bodyB->position + B->orientation * B->verticesArray[i];
+        faceNormals[i] = B->orientation * B->normalVectors[i];
+    }
+
+    // separating axes of the core and the polygon are normals of faces of the polygon and the normal of the core;
+    // the capsule is radius thicker than its core, so only a separation larger than radius separates them
+    int face = 0;
+    float polySeparation = -FLT_MAX;
+    for (int i = 0; i < count; i++)
+    {
+        float s = std::min(dot(faceNormals[i], a - vertices[i]), dot(faceNormals[i], b - vertices[i]));
+        if (s > polySeparation)
+        {
+            polySeparation = s;
+            face = i;
+        }
+    }
+    if (polySeparation > radius)
+        return;
+
+    Vector2D axis = b - a;
+    axis.normalize();
+    Vector2D side(-axis.y, axis.x);
+    if (dot(side, bodyB->position - bodyA->position) < 0.0f)
+        side = -side;
+    float capsuleSeparation = FLT_MAX;
+    for (int i = 0; i < count; i++)
+        capsuleSeparation = std::min(capsuleSeparation, dot(side, vertices[i] - a));
+    if (capsuleSeparation > radius)
+        return;
+
+    // a face of the polygon is preferred as the reference, so capsules resting on polygons get normals of their faces;
+    // the bias is applied to separations of surfaces like in PolygonToPolygon
+    Vector2D incident[2];
+    Vector2D v1, v2, referenceNormal;
+    bool referenceCapsule = capsuleSeparation - radius > K_BIAS_RELATIVE * (polySeparation - radius) + K_BIAS_ABSOLUTE;
+    if (referenceCapsule)
+    {
+        int incidentFace = 0;
+        float minDot = FLT_MAX;
+        for (int i = 0; i < count; i++)
+        {
+            float d = dot(side, faceNormals[i]);
+            if (d < minDot)
+            {
+                minDot = d;
+                incidentFace = i;
+            }
+        }
+        v1 = a;
+        v2 = b;
+        referenceNormal = side;
+        incident[0] = vertices[incidentFace];
+        incident[1] = vertices[incidentFace + 1 < count ? incidentFace + 1 : 0];
+    }
+    else
+    {
+        v1 = vertices[face];
+        v2 = vertices[face + 1 < count ? face + 1 : 0];
+        referenceNormal = faceNormals[face];
+        incident[0] = a;
+        incident[1] = b;
+    }
+
+    // contacts lie halfway between the reference side and the incident points, whichever of them carries the radius
+    Vector2D sidePlaneNormal = v2 - v1;
+    sidePlaneNormal.normalize();
+    if (Clip(-sidePlaneNormal, -dot(sidePlaneNormal, v1), incident) == 2 && Clip(sidePlaneNormal, dot(sidePlaneNormal, v2), incident) == 2)
+    {
+        int cp = 0;
+        point->penetration = 0.0f;
+        for (int i = 0; i < 2; i++)
+        {
+            float separation = dot(referenceNormal, incident[i] - v1) - radius;
+            if (separation <= 0.0f)
+            {
+                point->contacts[cp++] = incident[i] - referenceNormal * ((referenceCapsule ? 0.0f : radius) + 0.5f * separation);
+                point->penetration -= separation;
+            }
+        }
+        if (cp > 0)
+        {
+            point->penetration /= (float)cp;
+            point->normal = referenceCapsule ? referenceNormal : -referenceNormal;
+            point->contact_count = cp;
+            return;
+        }
+    }
+
+    // otherwise an end of the capsule touches a corner of the polygon
+    float distancePower2 = FLT_MAX;
+    Vector2D c1 = a;
+    Vector2D c2 = vertices[0];
+    for (int i = 0; i < count; i++)
+    {
+        Vector2D p1, p2;
+        float d = ClosestPoints(a, b, vertices[i], vertices[i + 1 < count ? i + 1 : 0], p1, p2);
+        if (d < distancePower2)
+        {
+            distancePower2 = d;
+            c1 = p1;
+            c2 = p2;
+        }
+    }
+    float distance = std::sqrt(distancePower2);
+    if (distance > radius || distance <= EPSILON)
+        return;
+
+    point->contact_count = 1;
+    point->normal = (c2 - c1) / distance;
+    point->penetration = radius - distance;
+    point->contacts[0] = c2 - point->normal * (0.5f * point->penetration);
+}
+
+void PolygonToCapsule(ContactPoint* point, RigidBody* bodyA, RigidBody* bodyB)
+{
+    CapsuleToPolygon(point, bodyB, bodyA);
+    point->normal = -point->normal;
+}
+
+// corners of a chain flatter than this sine of the angle between segments are treated as flat
+const float chainCornerTolerance = 0.01f;
+
+// returns normal of the front side of a segment from a to b
+static Vector2D FrontNormal(const Vector2D& a, const Vector2D& b)
+{
+    Vector2D face = b - a;
+    Vector2D normal(face.y, -face.x);
+    normal.normalize();
+    return normal;
+}
+
+// returns whether a chain bends away from the front side of a segment at its vertex, so bodies can touch the corner
+// normal - front normal of the segment
+// vertex - end of the segment
+// ghost - vertex of the neighbouring segment next to it
+static bool IsConvexCorner(const Vector2D& normal, const Vector2D& vertex, const Vector2D& ghost)
+{
+    Vector2D side = ghost - vertex;
+    return dot(normal, side) < -chainCornerTolerance * side.length();
+}
+
+// returns whether direction lies between unit vectors from and to, which are less than half a turn apart
+static bool IsBetween(const Vector2D& direction, const Vector2D& from, const Vector2D& to)
+{
+    float turn = cross(from, to);
+    return cross(from, direction) * turn >= 0.0f && cross(direction, to) * turn >= 0.0f;
+}
+
+// returns whether a body with center behind a segment is pushed back to its front side - when it crossed the segment
+// during the last step or when it still reaches in front of the segment and sinks deeper; others pass through
+// previous - position of the body a step ago
+// reachesFront - whether a part of the body is in front of the segment
+static bool PushedBack(const ChainSegment& segment, const RigidBody* body, const Vector2D& previous, bool reachesFront)
+{
+    return dot(segment.normal, previous - segment.a) >= 0.0f || (reachesFront && dot(segment.normal, body->velocity) < 0.0f);
+}
+
+void CircleToSegment(ContactPoint* point, const ChainSegment& segment, RigidBody* body, const Vector2D& previous)
+{
+    const Circle* circle = (const Circle*)body->shape;
+    const Vector2D& center = body->position;
+    const Vector2D& a = segment.a;
+    const Vector2D& b = segment.b;
+    point->contact_count = 0;
+
+    // segments are one-sided, so a center behind the segment passes through it unless the circle is pushed back
+    float distance = dot(segment.normal, center - a);
+    if (distance > circle->radius)
+        return;
+    bool crossed = distance < 0.0f;
+    if (crossed && !PushedBack(segment, body, previous, distance > -circle->radius))
+        return;
+
+    Vector2D edge = b - a;
+    float t = dot(center - a, edge);
+    if (crossed && (t <= 0.0f || t >= edge.lengthPower2()))
+        return;
+
+    Vector2D closest;
+    if (t <= 0.0f)
+    {
+        // the center is over the previous segment, which takes it if it is in front of it
+        if (dot(a - segment.ghost1, a - center) > 0.0f && dot(FrontNormal(segment.ghost1, a), center - segment.ghost1) >= 0.0f)
+            return;
+        closest = a;
+    }
+    else if (t >= edge.lengthPower2())
+    {
+        // the common vertex belongs to the next segment unless the center is behind it
+        if (dot(FrontNormal(b, segment.ghost2), center - b) >= 0.0f)
+            return;
+        closest = b;
+    }
+    else
+    {
+        point->contact_count = 1;
+        point->normal = segment.normal;
+        point->penetration = circle->radius - distance;
+        point->contacts[0] = center - segment.normal * distance;
+        return;
+    }
+
+    Vector2D normal = center - closest;
+    float length = normal.length();
+    if (length > circle->radius)
+        return;
+
+    point->contact_count = 1;
+    point->normal = length > EPSILON ? normal * (1.0f / length) : segment.normal;
+    point->penetration = circle->radius - length;
+    point->contacts[0] = closest;
+}
+
+void PolygonToSegment(ContactPoint* point, const ChainSegment& segment, RigidBody* body, const Vector2D& previous)
+{
+    const Poly* poly = (const Poly*)body->shape;
+    const Vector2D& a = segment.a;
+    const Vector2D& b = segment.b;
+    const Vector2D& normal = segment.normal;
+    point->contact_count = 0;
+
+    Vector2D vertices[MaxPolyVertexCount];
+    Vector2D faceNormals[MaxPolyVertexCount];
+    int count = poly->verticesCount;
+    for (int i = 0; i < count; i++)
+    {
+        vertices[i] = body->position + poly->orientation * poly->verticesArray[i];
+        faceNormals[i] = poly->orientation * poly->normalVectors[i];
+    }
+
+    // separating axes are the normal of the segment and normals of faces of the polygon
+    float edgeSeparation = FLT_MAX;
+    float reach = -FLT_MAX;
+    for (int i = 0; i < count; i++)
+    {
+        float s = dot(normal, vertices[i] - a);
+        edgeSeparation = std::min(edgeSeparation, s);
+        reach = std::max(reach, s);
+    }
+    if (edgeSeparation > 0.0f)
+        return;
+
+    // segments are one-sided, so a polygon with center behind the segment passes through it unless it is pushed back;
+    // then it is pushed along the normal of the segment
+    bool crossed = dot(normal, body->position - a) < 0.0f;
+    if (crossed && !PushedBack(segment, body, previous, reach > 0.0f))
+        return;
+
+    int face = 0;
+    float polySeparation = -FLT_MAX;
+    for (int i = 0; i < count; i++)
+    {
+        float s = std::min(dot(faceNormals[i], a - vertices[i]), dot(faceNormals[i], b - vertices[i]));
+        if (s > polySeparation)
+        {
+            polySeparation = s;
+            face = i;
+        }
+    }
+    if (polySeparation > 0.0f && !crossed)
+        return;
+
+    // a face of the polygon is the reference only if it is clearly better and its normal fits the chain around the segment;
+    // at flat or concave corners the normal of the segment is used, so polygons don't catch on seams
+    bool referencePoly = !crossed && polySeparation > K_BIAS_RELATIVE * edgeSeparation + K_BIAS_ABSOLUTE;
+    if (referencePoly)
+    {
+        Vector2D direction = -faceNormals[face];
+        float along = dot(direction, b - a);
+        if (along < 0.0f)
+            referencePoly = IsConvexCorner(normal, a, segment.ghost1) && IsBetween(direction, FrontNormal(segment.ghost1, a), normal);
+        else if (along > 0.0f)
+            referencePoly = IsConvexCorner(normal, b, segment.ghost2) && IsBetween(direction, normal, FrontNormal(b, segment.ghost2));
+    }
+
+    Vector2D incidentFace[2];
+    Vector2D v1, v2, referenceNormal;
+    if (referencePoly)
+    {
+        v1 = vertices[face];
+        v2 = vertices[face + 1 < count ? face + 1 : 0];
+        referenceNormal = faceNormals[face];
+        incidentFace[0] = a;
+        incidentFace[1] = b;
+    }
+    else
+    {
+        int incident = 0;
+        float minDot = FLT_MAX;
+        for (int i = 0; i < count; i++)
+        {
+            float d = dot(normal, faceNormals[i]);
+            if (d < minDot)
+            {
+                minDot = d;
+                incident = i;
+            }
+        }
+        v1 = a;
+        v2 = b;
+        referenceNormal = normal;
+        incidentFace[0] = vertices[incident];
+        incidentFace[1] = vertices[incident + 1 < count ? incident + 1 : 0];
+    }
+
+    Vector2D sidePlaneNormal = v2 - v1;
+    sidePlaneNormal.normalize();
+    if (Clip(-sidePlaneNormal, -dot(sidePlaneNormal, v1), incidentFace) < 2)
+        return;
+    if (Clip(sidePlaneNormal, dot(sidePlaneNormal, v2), incidentFace) < 2)
+        return;
+
+    float referenceC = dot(referenceNormal, v1);
+    int cp = 0;
+    point->penetration = 0.0f;
+    for (int i = 0; i < 2; i++)
+    {
+        float separation = dot(referenceNormal, incidentFace[i]) - referenceC;
+        if (separation <= 0.0f)
+        {
+            point->contacts[cp++] = incidentFace[i];
+            point->penetration -= separation;
+        }
+    }
+    if (cp == 0)
+        return;
+
+    point->penetration /= (float)cp;
+    point->normal = referencePoly ? -referenceNormal : referenceNormal;
+    point->contact_count = cp;
+}
+
+void CapsuleToSegment(ContactPoint* point, const ChainSegment& segment, RigidBody* body, const Vector2D& previous)
+{
+    const Capsule* capsule = (const Capsule*)body->shape;
+    float radius = capsule->radius;
+    const Vector2D& a = segment.a;
+    const Vector2D& b = segment.b;
+    const Vector2D& normal = segment.normal;
+    point->contact_count = 0;
+
+    Vector2D p1, p2;
+    capsule->GetCore(p1, p2);
+    float s1 = dot(normal, p1 - a);
+    float s2 = dot(normal, p2 - a);
+    if (std::min(s1, s2) > radius)
+        return;
+
+    // segments are one-sided, so a capsule with center behind the segment passes through it unless it is pushed back
+    bool crossed = dot(normal, body->position - a) < 0.0f;
+    if (crossed && !PushedBack(segment, body, previous, std::max(s1, s2) + radius > 0.0f))
+        return;
+
+    // the core clipped to the sides of the segment touches its inside, like an incident face of a polygon
+    Vector2D incident[2] = { p1, p2 };
+    Vector2D sidePlaneNormal = b - a;
+    sidePlaneNormal.normalize();
+    if (Clip(-sidePlaneNormal, -dot(sidePlaneNormal, a), incident) == 2 && Clip(sidePlaneNormal, dot(sidePlaneNormal, b), incident) == 2)
+    {
+        int cp = 0;
+        point->penetration = 0.0f;
+        for (int i = 0; i < 2; i++)
+        {
+            float separation = dot(normal, incident[i] - a) - radius;
+            if (separation <= 0.0f)
+            {
+                point->contacts[cp++] = incident[i] - normal * (radius + 0.5f * separation);
+                point->penetration -= separation;
+            }
+        }
+        if (cp > 0)
+        {
+            point->penetration /= (float)cp;
+            point->normal = normal;
+            point->contact_count = cp;
+            return;
+        }
+    }
+    if (crossed)
+        return;
+
+    // otherwise an end of the capsule is near a vertex of the segment, which is shared with the neighbouring segment
+    Vector2D c1, c2;
+    float distancePower2 = ClosestPoints(p1, p2, a, b, c1, c2);
+    if (distancePower2 > radius * radius)
+        return;
+
+    Vector2D edge = b - a;
+    float t = dot(c2 - a, edge);
+    if (t <= 0.0f)
+    {
+        if (dot(a - segment.ghost1, a - c1) > 0.0f && dot(FrontNormal(segment.ghost1, a), c1 - segment.ghost1) >= 0.0f)
+            return;
+    }
+    else if (t >= edge.lengthPower2())
+    {
+        if (dot(FrontNormal(b, segment.ghost2), c1 - b) >= 0.0f)
+            return;
+    }
+    else
+        return;
+
+    float distance = std::sqrt(distancePower2);
+    point->contact_count = 1;
+    point->normal = distance > EPSILON ? (c1 - c2) / distance : normal;
+    point->penetration = radius - distance;
+    point->contacts[0] = c2 + point->normal * (0.5f * (distance - radius));
+}
+
+void ChainToShape(RigidBody* bodyA, RigidBody* bodyB, float dt, std::vector<ContactPoint>& contacts)
+{
+    bool chainA = bodyA->shape->GetType() == Shape::ChainID;
+    RigidBody* other = chainA ? bodyB : bodyA;
+    const Chain* chain = (const Chain*)(chainA ? bodyA : bodyB)->shape;
+    int type = other->shape->GetType();
+    Vector2D previous = other->position - other->velocity * dt;
+
+    // segments are searched along the whole move of the last step, so segments crossed by fast bodies are found too
+    AABB box = other->shape->GetAABB();
+    Vector2D back = previous - other->position;
+    box = box.Combine(AABB(box.min + back, box.max + back));
+
+    // contact normals point from the chain, so they are turned when the chain is the second body
+    chain->Query(chain->ToLocal(box), [&](int index)
+    {
+        ChainSegment segment = chain->GetSegment(index);
+        ContactPoint m(bodyA, bodyB);
+        if (type == Shape::CircleID)
+            CircleToSegment(&m, segment, other, previous);
+        else if (type == Shape::CapsuleID)
+            CapsuleToSegment(&m, segment, other, previous);
+        else
+            PolygonToSegment(&m, segment, other, previous);
+
+        if (m.contact_count)
+        {
+            if (!chainA)
+                m.normal = -m.normal;
+            contacts.push_back(m);
+        }
+        return true;
+    });
+}
+
 float FindAxisLeastPenetration(int* faceIndex, Poly* polyA, Poly* polyB)
 {
     float bestDistance = -FLT_MAX;
@@ -305,4 +916,182 @@ void PolygonToPolygon(ContactPoint* point, RigidBody* bodyA, RigidBody* bodyB)
     }
 
     point->contact_count = cp;
-}
\ No newline at end of file
+}
+
+float DistanceToSegment(const Vector2D& p, const Vector2D& a, const Vector2D& b)
+{
+    Vector2D edge = b - a;
+    float length = edge.lengthPower2();
+    float t = length > 0.0f ? std::min(1.0f, std::max(0.0f, dot(p - a, edge) / length)) : 0.0f;
+    return (p - (a + edge * t)).length();
+}
+
+// returns distance of point from convex polygon given in any order around it; 0 inside
+float DistanceToPolygon(const Vector2D& point, const Vector2D* vertices, int count)
+{
+    float winding = 0.0f;
+    for (int i = 0; i < count; i++)
+        winding += cross(vertices[i], vertices[(i + 1) % count]);
+
+    bool inside = true;
+    float distance = FLT_MAX;
+    for (int i = 0; i < count; i++)
+    {
+        const Vector2D& a = vertices[i];
+        const Vector2D& b = vertices[(i + 1) % count];
+        if (cross(b - a, point - a) * winding < 0.0f)
+            inside = false;
+        distance = std::min(distance, DistanceToSegment(point, a, b));
+    }
+    return inside ? 0.0f : distance;
+}
+
+float DistanceBetweenSegments(const Vector2D& a1, const Vector2D& b1, const Vector2D& a2, const Vector2D& b2)
+{
+    Vector2D c1, c2;
+    return std::sqrt(ClosestPoints(a1, b1, a2, b2, c1, c2));
+}
+
+float DistanceToPolygon(const Vector2D& a, const Vector2D& b, const Vector2D* vertices, int count)
+{
+    // a segment which doesn't cross the boundary is either outside or has its end inside
+    if (DistanceToPolygon(a, vertices, count) == 0.0f)
+        return 0.0f;
+
+    float distance = FLT_MAX;
+    for (int i = 0; i < count; i++)
+        distance = std::min(distance, DistanceBetweenSegments(a, b, vertices[i], vertices[(i + 1) % count]));
+    return distance;
+}
+
+// writes vertices of a polygon body in coordinates of the world; returns their number
+int WorldVertices(const RigidBody* body, Vector2D* out)
+{
+    const Poly* poly = (const Poly*)body->shape;
+    for (int i = 0; i < poly->verticesCount; i++)
+        out[i] = body->position + poly->orientation * poly->verticesArray[i];
+    return poly->verticesCount;
+}
+
+// returns whether some edge normal of polygon a separates it from polygon b
+static bool Separated(const Vector2D* a, int countA, const Vector2D* b, int countB)
+{
+    for (int i = 0; i < countA; i++)
+    {
+        Vector2D edge = a[(i + 1) % countA] - a[i];
+        Vector2D axis(-edge.y, edge.x);
+
+        float minA = FLT_MAX, maxA = -FLT_MAX;
+        for (int j = 0; j < countA; j++)
+        {
+            float projection = dot(axis, a[j]);
+            minA = std::min(minA, projection);
+            maxA = std::max(maxA, projection);
+        }
+
+        float minB = FLT_MAX, maxB = -FLT_MAX;
+        for (int j = 0; j < countB; j++)
+        {
+            float projection = dot(axis, b[j]);
+            minB = std::min(minB, projection);
+            maxB = std::max(maxB, projection);
+        }
+
+        if (maxA < minB || maxB < minA)
+            return true;
+    }
+    return false;
+}
+
+bool PolygonsOverlap(const Vector2D* a, int countA, const Vector2D* b, int countB)
+{
+    return !Separated(a, countA, b, countB) && !Separated(b, countB, a, countA);
+}
+
+bool ChainOverlapsPolygon(const RigidBody* chain, const Vector2D* vertices, int count)
+{
+    const Chain* shape = (const Chain*)chain->shape;
+    AABB box(vertices[0], vertices[0]);
+    for (int i = 1; i < count; i++)
+        box = box.Combine(AABB(vertices[i], vertices[i]));
+
+    bool overlaps = false;
+    shape->Query(shape->ToLocal(box), [&](int index)
+    {
+        ChainSegment segment = shape->GetSegment(index);
+        Vector2D ends[2] = { segment.a, segment.b };
+        overlaps = PolygonsOverlap(ends, 2, vertices, count);
+        return !overlaps;
+    });
+    return overlaps;
+}
+
+// writes core segment of a circle or a capsule in coordinates of the world; returns its radius or a negative value for other shapes
+static float RoundCore(const RigidBody* body, Vector2D& a, Vector2D& b)
+{
+    if (body->shape->GetType() == Shape::CircleID)
+    {
+        a = b = body->position;
+        return ((const Circle*)body->shape)->radius;
+    }
+    if (body->shape->GetType() == Shape::CapsuleID)
+    {
+        ((const Capsule*)body->shape)->GetCore(a, b);
+        return ((const Capsule*)body->shape)->radius;
+    }
+    return -1.0f;
+}
+
+bool TestOverlap(const RigidBody* bodyA, const RigidBody* bodyB)
+{
+    // circles and capsules are segments with radius, so they are tested by the distance of their cores
+    Vector2D a1, b1, a2, b2;
+    float radiusA, radiusB;
+
+    // chains are static, so at most one of the bodies has a chain
+    if (bodyB->shape->GetType() == Shape::ChainID)
+        std::swap(bodyA, bodyB);
+    if (bodyA->shape->GetType() == Shape::ChainID)
+    {
+        const Chain* chain = (const Chain*)bodyA->shape;
+        if (bodyB->shape->GetType() == Shape::CircleID)
+            return chain->Distance(bodyB->position) < ((const Circle*)bodyB->shape)->radius;
+        if (bodyB->shape->GetType() == Shape::CapsuleID)
+        {
+            radiusB = RoundCore(bodyB, a2, b2);
+            bool overlaps = false;
+            chain->Query(chain->ToLocal(bodyB->shape->GetAABB()), [&](int index)
+            {
+                ChainSegment segment = chain->GetSegment(index);
+                overlaps = DistanceBetweenSegments(segment.a, segment.b, a2, b2) < radiusB;
+                return !overlaps;
+            });
+            return overlaps;
+        }
+
+        Vector2D corners[MaxPolyVertexCount];
+        int count = WorldVertices(bodyB, corners);
+        return ChainOverlapsPolygon(bodyA, corners, count);
+    }
+
+    radiusA = RoundCore(bodyA, a1, b1);
+    radiusB = RoundCore(bodyB, a2, b2);
+
+    if (radiusA >= 0.0f && radiusB >= 0.0f)
+        return DistanceBetweenSegments(a1, b1, a2, b2) < radiusA + radiusB;
+
+    if (radiusA >= 0.0f || radiusB >= 0.0f)
+    {
+        const RigidBody* poly = radiusA >= 0.0f ? bodyB : bodyA;
+        Vector2D corners[MaxPolyVertexCount];
+        int count = WorldVertices(poly, corners);
+        if (radiusA >= 0.0f)
+            return DistanceToPolygon(a1, b1, corners, count) < radiusA;
+        return DistanceToPolygon(a2, b2, corners, count) < radiusB;
+    }
+
+    Vector2D cornersA[MaxPolyVertexCount], cornersB[MaxPolyVertexCount];
+    int countA = WorldVertices(bodyA, cornersA);
+    int countB = WorldVertices(bodyB, cornersB);
+    return PolygonsOverlap(cornersA, countA, cornersB, countB);
+}
@@ -9,6 +9,8 @@
 
 class RigidBody;
 class ContactPoint;
+class Poly;
+struct ChainSegment;
 
 // solves circle - circle collision
 void CircleToCircle(ContactPoint* point, RigidBody* bodyA, RigidBody* bodyB);
@@ -22,4 +24,81 @@ void PolygonToCircle(ContactPoint* point, RigidBody* bodyA, RigidBody* bodyB);
 // solves polygon - polygon collision
 void PolygonToPolygon(ContactPoint* point, RigidBody* bodyA, RigidBody* bodyB);
 
+// solves capsule - circle collision
+void CapsuleToCircle(ContactPoint* point, RigidBody* bodyA, RigidBody* bodyB);
+
+// solves circle - capsule collision
+void CircleToCapsule(ContactPoint* point, RigidBody* bodyA, RigidBody* bodyB);
+
+// solves capsule - capsule collision; nearly parallel capsules touch at two points
+void CapsuleToCapsule(ContactPoint* point, RigidBody* bodyA, RigidBody* bodyB);
+
+// solves capsule - polygon collision
+void CapsuleToPolygon(ContactPoint* point, RigidBody* bodyA, RigidBody* bodyB);
+
+// solves polygon - capsule collision
+void PolygonToCapsule(ContactPoint* point, RigidBody* bodyA, RigidBody* bodyB);
+
+// solves segment - circle collision; the normal points from the segment to the circle
+// segment - segment of a chain with its ghost vertices
+// body - body of the circle
+// previous - position of the body a step ago
+void CircleToSegment(ContactPoint* point, const ChainSegment& segment, RigidBody* body, const Vector2D& previous);
+
+// solves segment - polygon collision; the normal points from the segment to the polygon
+// segment - segment of a chain with its ghost vertices
+// body - body of the polygon
+// previous - position of the body a step ago
+void PolygonToSegment(ContactPoint* point, const ChainSegment& segment, RigidBody* body, const Vector2D& previous);
+
+// solves segment - capsule collision; the normal points from the segment to the capsule
+// segment - segment of a chain with its ghost vertices
+// body - body of the capsule
+// previous - position of the body a step ago
+void CapsuleToSegment(ContactPoint* point, const ChainSegment& segment, RigidBody* body, const Vector2D& previous);
+
+// solves collision of a chain with another body; one contact is appended for every touched segment
+// bodyA, bodyB - colliding bodies in order of the pair, one of them with a chain
+// dt - time step, with which the position of the body a step ago is found
+// contacts - list to which contacts are appended
+void ChainToShape(RigidBody* bodyA, RigidBody* bodyB, float dt, std::vector<ContactPoint>& contacts);
+
+// finds face of polyA with the greatest separation from polyB; negative value means penetration
+// faceIndex - index of found face of polyA
+float FindAxisLeastPenetration(int* faceIndex, Poly* polyA, Poly* polyB);
+
+// finds face of IncPoly which is the most anti-parallel to a face of RefPoly
+// vector - two world space vertices of found face
+// referenceIndex - index of face of RefPoly
+void FindIncidentFace(Vector2D* vector, Poly* RefPoly, Poly* IncPoly, int referenceIndex);
+
+// clips segment to the half plane dot( normalVector, x ) <= c; returns number of remaining points
+// face - two points of the segment, replaced by clipped points
+int Clip(Vector2D normalVector, float c, Vector2D* face);
+
+// writes vertices of a polygon body in coordinates of the world; returns their number
+// out - array of at least MaxPolyVertexCount vectors
+int WorldVertices(const RigidBody* body, Vector2D* out);
+
+// returns distance of point p from segment a - b
+float DistanceToSegment(const Vector2D& p, const Vector2D& a, const Vector2D& b);
+
+// returns distance of point from convex polygon given in any order around it; 0 inside
+float DistanceToPolygon(const Vector2D& point, const Vector2D* vertices, int count);
+
+// returns distance between segments a1 - b1 and a2 - b2
+float DistanceBetweenSegments(const Vector2D& a1, const Vector2D& b1, const Vector2D& a2, const Vector2D& b2);
+
+// returns distance of segment a - b from convex polygon given in any order around it; 0 if they overlap
+float DistanceToPolygon(const Vector2D& a, const Vector2D& b, const Vector2D* vertices, int count);
+
+// returns whether two convex polygons given in coordinates of the world overlap
+bool PolygonsOverlap(const Vector2D* a, int countA, const Vector2D* b, int countB);
+
+// returns whether some colliding segment of a chain overlaps convex polygon given in coordinates of the world
+bool ChainOverlapsPolygon(const RigidBody* chain, const Vector2D* vertices, int count);
+
+// returns whether shapes of two bodies overlap; unlike the functions above it builds no contact manifold
+bool TestOverlap(const RigidBody* bodyA, const RigidBody* bodyB);
+
 #endif // COLLISION_H
\ No newline at end of file
@@ -0,0 +1,98 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#include "IncludesManager.h"
+
+CommandQueue::CommandQueue()
+{
+    head = nullptr;
+}
+
+CommandQueue::~CommandQueue()
+{
+    Release(TakeAll());
+}
+
+void CommandQueue::Add(const Shape* shape, const BodyDefinition& definition)
+{
+    assert(shape);
+    Command* command = new Command();
+    command->type = Command::AddBody;
+    command->shape = shape->Copy();
+    command->definition = definition;
+    Push(command);
+}
+
+void CommandQueue::Remove(unsigned int bodyId)
+{
+    Command* command = new Command();
+    command->type = Command::RemoveBody;
+    command->bodyId = bodyId;
+    Push(command);
+}
+
+void CommandQueue::ApplyImpulse(unsigned int bodyId, const Vector2D& impulse, const Vector2D& contactVector)
+{
+    Command* command = new Command();
+    command->type = Command::ApplyImpulse;
+    command->bodyId = bodyId;
+    command->vector = impulse;
+    command->contactVector = contactVector;
+    Push(command);
+}
+
+void CommandQueue::SetVelocity(unsigned int bodyId, const Vector2D& linearVelocity, float _angularVelocity)
+{
+    Command* command = new Command();
+    command->type = Command::SetVelocity;
+    command->bodyId = bodyId;
+    command->vector = linearVelocity;
+    command->angularVelocity = _angularVelocity;
+    Push(command);
+}
+
+void CommandQueue::SetFilter(unsigned int bodyId, const CollisionFilter& filter)
+{
+    Command* command = new Command();
+    command->type = Command::SetFilter;
+    command->bodyId = bodyId;
+    command->filter = filter;
+    Push(command);
+}
+
+Command* CommandQueue::TakeAll()
+{
+    // the stack is taken as a whole, so the consumer never competes with producers for single commands
+    Command* stack = head.exchange(nullptr, std::memory_order_acquire);
+
+    // the newest command is on the top, so the list is reversed to restore order of pushing
+    Command* commands = nullptr;
+    while (stack)
+    {
+        Command* next = stack->next;
+        stack->next = commands;
+        commands = stack;
+        stack = next;
+    }
+    return commands;
+}
+
+void CommandQueue::Release(Command* commands)
+{
+    while (commands)
+    {
+        Command* next = commands->next;
+        delete commands->shape;
+        delete commands;
+        commands = next;
+    }
+}
+
+void CommandQueue::Push(Command* command)
+{
+    command->next = head.load(std::memory_order_relaxed);
+    while (!head.compare_exchange_weak(command->next, command, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+}
@@ -0,0 +1,87 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#ifndef COMMANDQUEUE_H
+#define COMMANDQUEUE_H
+
+class Shape;
+
+
+// change of the world requested from any thread
+struct Command
+{
+    enum Type
+    {
+        AddBody,
+        RemoveBody,
+        ApplyImpulse,
+        SetVelocity,
+        SetFilter,
+    };
+
+    Type type;
+    unsigned int bodyId;         // target body of every command except AddBody
+    Shape* shape;                // AddBody - own copy of the shape
+    BodyDefinition definition;   // AddBody - initial state and material
+    Vector2D vector;             // ApplyImpulse - impulse, SetVelocity - linear velocity
+    Vector2D contactVector;      // ApplyImpulse - point of impulse action relative to body center
+    float angularVelocity;       // SetVelocity - angular velocity
+    CollisionFilter filter;      // SetFilter - new filter of the body
+
+    Command* next;
+};
+
+
+// CommandQueue class - lock-free queue of commands with many producers and one consumer
+// producers push commands with an atomic compare-and-swap and never wait on a lock or for the consumer;
+// the consumer takes all pending commands at once and applies them in order of pushing
+class CommandQueue
+{
+public:
+    // constructor
+    CommandQueue();
+
+    // destructor - releases commands which were never taken
+    ~CommandQueue();
+
+    // requests adding a new body
+    // shape - shape of the body; it is copied, so it can be released after the call
+    // definition - initial state and material of the body
+    void Add(const Shape* shape, const BodyDefinition& definition);
+
+    // requests removing a body
+    // bodyId - id of the body to remove
+    void Remove(unsigned int bodyId);
+
+    // requests applying an impulse to a body
+    // bodyId - id of the target body
+    // impulse - vector of force impulse
+    // contactVector - point of impulse action relative to body center
+    void ApplyImpulse(unsigned int bodyId, const Vector2D& impulse, const Vector2D& contactVector);
+
+    // requests setting body velocities
+    // bodyId - id of the target body
+    // linearVelocity - linear velocity to set
+    // _angularVelocity - angular velocity to set
+    void SetVelocity(unsigned int bodyId, const Vector2D& linearVelocity, float _angularVelocity);
+
+    // requests changing which bodies a body collides with
+    // bodyId - id of the target body
+    // filter - category, mask and group to set
+    void SetFilter(unsigned int bodyId, const CollisionFilter& filter);
+
+    // takes all pending commands in order of pushing; the caller releases them with Release
+    Command* TakeAll();
+
+    // releases list of commands returned by TakeAll
+    static void Release(Command* commands);
+
+private:
+    std::atomic<Command*> head;
+
+    // pushes command on the top of the stack of pending commands
+    void Push(Command* command);
+};
+
+#endif // COMMANDQUEUE_H
@@ -7,10 +7,30 @@
 
 #include "Math.h"
 
+// default values of world parameters
 const float gravityScale = 5.0f;
-const Vector2D gravity(0.0f, 9.81f * gravityScale);
-const float dt = 1.0f / 60.0f;
+const Vector2D defaultGravity(0.0f, 9.81f * gravityScale);
+const float defaultDt = 1.0f / 60.0f;
+const unsigned int defaultIterations = 10;
 
 
+// WorldSettings struct - physical parameters of a single world
+struct WorldSettings
+{
+    Vector2D gravity = defaultGravity;          // in [ meter / second^2 ]
+    float dt = defaultDt;                       // in [ second ]
+    unsigned int iterations = defaultIterations;
+    float penetrationAllowance = 0.05f;         // in [ meter ]
+    float penetrationPercent = 0.4f;            // dimensionless
 
-#endif CONSTANS_H
\ No newline at end of file
+    // returns whether a world can be stepped with the settings; settings read from files are checked with it,
+    // because the number of steps of a session is computed from dt, so dt is also kept away from zero
+    bool IsValid() const
+    {
+        return std::isfinite(gravity.x) && std::isfinite(gravity.y) && std::isfinite(dt) && dt >= 1e-6f && dt <= 1.0f &&
+            iterations > 0 && std::isfinite(penetrationAllowance) && penetrationAllowance >= 0.0f &&
+            std::isfinite(penetrationPercent) && penetrationPercent >= 0.0f;
+    }
+};
+
+#endif // CONSTANS_H
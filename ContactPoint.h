@@ -25,6 +25,7 @@ public:
     float resultantRestitution;              
     float resultantKineticFriction;            
     float resultantStaticFriction;   
+    float normalImpulse;                    // sum of normal impulses applied by the solver in [ Newton * second ]
 
     float penetrationAllowance = 0.05f;
     float penetrationPercent = 0.4f;
@@ -35,6 +36,8 @@ public:
     {
         bodyA = _bodyA;
         bodyB = _bodyB;
+        contact_count = 0;
+        normalImpulse = 0.0f;
 
         if (bodyA->restitution > bodyB->restitution)
             resultantRestitution = bodyB->restitution;
@@ -42,6 +45,14 @@ public:
             resultantRestitution = bodyA->restitution;
         resultantStaticFriction = std::sqrt(bodyA->staticFriction * bodyB->staticFriction);
         resultantKineticFriction = std::sqrt(bodyA->kinetcFriction * bodyB->kinetcFriction);
+    }
+
+    // prepares solved contact for impulse resolution
+    // settings - parameters of the world in which collision occurs
+    void Initialize(const WorldSettings& settings)
+    {
+        penetrationAllowance = settings.penetrationAllowance;
+        penetrationPercent = settings.penetrationPercent;
 
         for (int i = 0; i < contact_count; i++)
         {
@@ -50,7 +61,8 @@ public:
 
             Vector2D rv = bodyB->velocity + cross(bodyB->angularVelocity, rb) - bodyA->velocity - cross(bodyA->angularVelocity, ra);
 
-            if (rv.lengthPower2() < (dt * gravity).lengthPower2() + EPSILON)
+            // resting contact - the only velocity comes from gravity, so collision should be perfectly inelastic
+            if (rv.lengthPower2() < (settings.dt * settings.gravity).lengthPower2() + EPSILON)
                 resultantRestitution = 0.0f;
         }
     }
@@ -58,16 +70,35 @@ public:
     // solves collision
     void Solve()
     {
-        if (bodyA->shape->GetType() == bodyB->shape->GetType())
+        int typeA = bodyA->shape->GetType();
+        int typeB = bodyB->shape->GetType();
+
+        if (typeA == Shape::CapsuleID)
+        {
+            if (typeB == Shape::CircleID)
+                CapsuleToCircle(this, bodyA, bodyB);
+            else if (typeB == Shape::CapsuleID)
+                CapsuleToCapsule(this, bodyA, bodyB);
+            else
+                CapsuleToPolygon(this, bodyA, bodyB);
+        }
+        else if (typeB == Shape::CapsuleID)
+        {
+            if (typeA == Shape::CircleID)
+                CircleToCapsule(this, bodyA, bodyB);
+            else
+                PolygonToCapsule(this, bodyA, bodyB);
+        }
+        else if (typeA == typeB)
         {
-            if (bodyA->shape->GetType() == 0)
+            if (typeA == Shape::CircleID)
                 CircleToCircle(this, bodyA, bodyB);
             else
                 PolygonToPolygon(this, bodyA, bodyB);
         }
         else
         {
-            if (bodyA->shape->GetType() == 0)
+            if (typeA == Shape::CircleID)
                 CircleToPolygon(this, bodyA, bodyB);
             else
                 PolygonToCircle(this, bodyA, bodyB);
@@ -107,6 +138,7 @@ public:
             j /= (float)contact_count;
 
             Vector2D impulse = normal * j;
+            normalImpulse += j;
             bodyA->ApplyImpulse(-impulse, ra);
             bodyB->ApplyImpulse(impulse, rb);
 
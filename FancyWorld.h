@@ -8,7 +8,21 @@
 #include "IncludesManager.h"
 
 World scene(1.0f/60.0f, 10);
-Timer clock;
+PerformanceChart chart;
+
+// log of spawned bodies; the session is recorded when inputLogPath is set before InitFancyWorld
+// seed of random shapes, set by --seed and written to the header of the log
+InputLog inputLog;
+const char* inputLogPath = nullptr;
+unsigned int seed = 1;
+
+// shared memory for an external viewer; the world is published when exportName is set before InitFancyWorld
+SharedStateExport sharedExport;
+const char* exportName = nullptr;
+
+// the thread steps the world and writes to the chart, the log and the shared memory, so it is declared after them;
+// globals are destroyed in reverse order, so it is joined before they are closed even when GLUT exits on its own
+SimulationThread simulation(scene);
 
 // mouse moves definition
 void mouse(int button, int state, int x, int y)
@@ -16,6 +30,10 @@ void mouse(int button, int state, int x, int y)
     x /= 10.0f;
     y /= 10.0f;
 
+    // the world is stepped on the simulation thread, so new bodies are passed through the command queue
+    BodyDefinition definition;
+    definition.position = Vector2D((float)x, (float)y);
+
     if (state == GLUT_DOWN)
         switch (button)
         {
@@ -30,20 +48,34 @@ void mouse(int button, int state, int x, int y)
             }
 
             Poly poly(vertices, count);
-            RigidBody* body = scene.Add(&poly, x, y);
-            body->SetOrientation(random(-PI, PI));
-            body->restitution = 0.4f;
-            body->kinetcFriction = 0.2f;
-            body->staticFriction = 0.4f;
-            body->SetColor(random(0, 1), random(0, 1), random(0, 1));
+            definition.orientation = random(-PI, PI);
+            definition.restitution = 0.4f;
+            definition.kineticFriction = 0.2f;
+            definition.staticFriction = 0.4f;
+            definition.color.red = random(0, 1);
+            definition.color.green = random(0, 1);
+            definition.color.blue = random(0, 1);
+            scene.commands.Add(&poly, definition);
             delete[] vertices;
         }
         break;
         case GLUT_RIGHT_BUTTON:
         {
             Circle circ (random(1.0f, 3.0f));
-            RigidBody* body = scene.Add(&circ, x, y);
-            body->SetColor(random(0, 1), random(0, 1), random(0, 1));
+            definition.color.red = random(0, 1);
+            definition.color.green = random(0, 1);
+            definition.color.blue = random(0, 1);
+            scene.commands.Add(&circ, definition);
+        }
+        break;
+        case GLUT_MIDDLE_BUTTON:
+        {
+            Capsule capsule(random(1.0f, 4.0f), random(0.5f, 2.0f));
+            definition.orientation = random(-PI, PI);
+            definition.color.red = random(0, 1);
+            definition.color.green = random(0, 1);
+            definition.color.blue = random(0, 1);
+            scene.commands.Add(&capsule, definition);
         }
         break;
         }
@@ -55,8 +87,12 @@ void keyboard(unsigned char key, int x, int y)
     switch (key)
     {
     case 27:
+        simulation.Stop();
         exit(0);
         break;
+    case 'p':
+        chart.Toggle();
+        break;
     }
 }
 
@@ -64,26 +100,9 @@ void loop()
 {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    static double accumulator = 0;
-    accumulator += clock.Time();
-
-    clock.Start();
-
-    //accumulator = clamp(0.0f, 0.1f, accumulator);
-
-    if (accumulator < 0.0) 
-        accumulator = 0.0;
-    if (accumulator > 0.1) 
-        accumulator = 0.1;
-
-    while (accumulator >= dt)
-    {
-        scene.Step();
-        accumulator -= dt;
-    }
-
-    clock.Stop();
-    scene.Render();
+    // physics runs on the simulation thread, here is only drawing
+    simulation.Render(glutGet(GLUT_WINDOW_WIDTH) / 80.0f);
+    chart.Draw();
     glutSwapBuffers();
 }
 
@@ -108,14 +127,22 @@ void InitFancyWorld(int argc, char** argv)
     glPushMatrix();
     glLoadIdentity();
 
-    RigidBody* body; 
+    srand(seed);
+    if (inputLogPath && inputLog.Open(inputLogPath, seed, scene.settings))
+        scene.SetInputLog(&inputLog);
+    if (exportName && sharedExport.Open(exportName, 16384, 1 << 20, scene.settings.dt))
+        scene.SetExporter(&sharedExport);
 
+    // the floor is a command too, so a recorded session contains the whole scene
     Rect rect(50.0f, 1.0f);
-    body = scene.Add(&rect, 40, 55);
-    body->SetStatic();
-    body->SetOrientation(0);
-
-    srand(1);
+    BodyDefinition floor;
+    floor.position = Vector2D(40.0f, 55.0f);
+    floor.isStatic = true;
+    scene.commands.Add(&rect, floor);
+
+    simulation.SetChart(&chart);
+    simulation.SetView(AABB(Vector2D(0.0f, 0.0f), Vector2D(80.0f, 60.0f)));
+    simulation.Start();
     glutMainLoop();
 }
 
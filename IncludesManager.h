@@ -13,19 +13,42 @@
 #include <cstring> 
 #include <cstdlib> 
 #include <cfloat>  
+#include <climits>
 #include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include "GL\glut.h"
 
 #include "Math.h"
 #include "Timer.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "JobSystem.h"
+#include "Broadphase.h"
 #include "RigidBody.h"
 #include "Shape.h"
 	#include "Circle.h"
 	#include "Polygon.h"
 		#include "Rectangle.h"
+	#include "Chain.h"
+	#include "Capsule.h"
 #include "Collision.h"
 #include "ContactPoint.h"
+#include "RenderBatch.h"
+#include "CommandQueue.h"
+#include "Trajectory.h"
+#include "InputLog.h"
+#include "SharedState.h"
 #include "World.h"
+#include "BatchRunner.h"
+#include "Chart.h"
+#include "SimulationThread.h"
+#include "WorldFile.h"
+#include "SnapshotBuffer.h"
+#include "Rasterizer.h"
+#include "SpatialQuery.h"
 
 #endif // INCLUDESMANAGER_H
\ No newline at end of file
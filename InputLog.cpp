@@ -0,0 +1,398 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#include "IncludesManager.h"
+
+static_assert(sizeof(InputLogHeader) == 48, "input log header layout changed");
+static_assert(sizeof(InputRecord) == 128, "input log record layout changed");
+
+
+InputLog::InputLog()
+{
+    file = nullptr;
+    written = false;
+}
+
+InputLog::~InputLog()
+{
+    Close();
+}
+
+bool InputLog::Open(const char* path, unsigned int seed, const WorldSettings& settings)
+{
+    Close();
+
+    if (fopen_s(&file, path, "wb") != 0)
+    {
+        file = nullptr;
+        return false;
+    }
+
+    InputLogHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, inputLogMagic, sizeof(header.magic));
+    header.version = inputLogVersion;
+    header.byteOrder = worldFileByteOrder;
+    header.seed = seed;
+    header.gravity[0] = settings.gravity.x;
+    header.gravity[1] = settings.gravity.y;
+    header.dt = settings.dt;
+    header.iterations = settings.iterations;
+    header.penetrationAllowance = settings.penetrationAllowance;
+    header.penetrationPercent = settings.penetrationPercent;
+
+    if (fwrite(&header, sizeof(header), 1, file) != 1 || fflush(file) != 0)
+    {
+        fclose(file);
+        file = nullptr;
+        return false;
+    }
+
+    start = std::chrono::steady_clock::now();
+    written = false;
+    return true;
+}
+
+void InputLog::Close()
+{
+    if (file)
+        fclose(file);
+    file = nullptr;
+}
+
+void InputLog::Record(unsigned long long step, const Command& command)
+{
+    if (!file)
+        return;
+
+    InputRecord record;
+    memset(&record, 0, sizeof(record));
+    record.step = step;
+    record.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    record.type = command.type;
+    record.bodyId = command.bodyId;
+
+    const Poly* poly = nullptr;
+    const Chain* chain = nullptr;
+    const Capsule* capsule = nullptr;
+    if (command.type == Command::AddBody)
+    {
+        record.shapeType = command.shape->GetType();
+        if (record.shapeType == Shape::CircleID)
+        {
+            record.radius = ((const Circle*)command.shape)->radius;
+        }
+        else if (record.shapeType == Shape::CapsuleID)
+        {
+            capsule = (const Capsule*)command.shape;
+            record.radius = capsule->radius;
+            record.vertexCount = 2;
+        }
+        else if (record.shapeType == Shape::ChainID)
+        {
+            chain = (const Chain*)command.shape;
+            record.vertexCount = (uint32_t)chain->vertices.size();
+            record.isLoop = chain->loop;
+        }
+        else
+        {
+            poly = (const Poly*)command.shape;
+            record.vertexCount = poly->verticesCount;
+        }
+
+        const BodyDefinition& definition = command.definition;
+        record.position[0] = definition.position.x;
+        record.position[1] = definition.position.y;
+        record.orientation = definition.orientation;
+        record.velocity[0] = definition.velocity.x;
+        record.velocity[1] = definition.velocity.y;
+        record.angularVelocity = definition.angularVelocity;
+        record.staticFriction = definition.staticFriction;
+        record.kineticFriction = definition.kineticFriction;
+        record.restitution = definition.restitution;
+        record.density = definition.density;
+        record.isStatic = definition.isStatic;
+        record.color[0] = definition.color.red;
+        record.color[1] = definition.color.green;
+        record.color[2] = definition.color.blue;
+        record.filterCategory = definition.filter.category;
+        record.filterMask = definition.filter.mask;
+        record.filterGroup = definition.filter.group;
+        record.isSensor = definition.isSensor;
+    }
+    else if (command.type == Command::SetFilter)
+    {
+        record.filterCategory = command.filter.category;
+        record.filterMask = command.filter.mask;
+        record.filterGroup = command.filter.group;
+    }
+    else
+    {
+        record.vector[0] = command.vector.x;
+        record.vector[1] = command.vector.y;
+        record.contactVector[0] = command.contactVector.x;
+        record.contactVector[1] = command.contactVector.y;
+        record.commandAngularVelocity = command.angularVelocity;
+    }
+
+    fwrite(&record, sizeof(record), 1, file);
+    for (int i = 0; poly && i < poly->verticesCount; i++)
+    {
+        float values[4] = { poly->verticesArray[i].x, poly->verticesArray[i].y, poly->normalVectors[i].x, poly->normalVectors[i].y };
+        fwrite(values, sizeof(values), 1, file);
+    }
+    for (unsigned int i = 0; chain && i < chain->vertices.size(); i++)
+    {
+        float values[4] = { chain->vertices[i].x, chain->vertices[i].y, chain->normals[i].x, chain->normals[i].y };
+        fwrite(values, sizeof(values), 1, file);
+    }
+    for (int i = 0; capsule && i < 2; i++)
+    {
+        // ends of the core segment; capsules have no face normals
+        float values[4] = { i == 0 ? -capsule->halfLength : capsule->halfLength, 0.0f, 0.0f, 0.0f };
+        fwrite(values, sizeof(values), 1, file);
+    }
+    written = true;
+}
+
+void InputLog::Flush()
+{
+    if (file && written)
+        fflush(file);
+    written = false;
+}
+
+
+bool InputReplay::Open(const char* path)
+{
+    events.clear();
+    nextEvent = 0;
+
+    FILE* file;
+    if (fopen_s(&file, path, "rb") != 0)
+        return false;
+
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+        memcmp(header.magic, inputLogMagic, sizeof(header.magic)) == 0 &&
+        header.version == inputLogVersion && header.byteOrder == worldFileByteOrder && GetSettings().IsValid();
+
+    // a record cut by an interrupted session ends the log
+    InputEvent event;
+    while (valid && fread(&event.record, sizeof(event.record), 1, file) == 1)
+    {
+        const InputRecord& record = event.record;
+        if (record.type > Command::SetFilter || (!events.empty() && record.step < events.back().record.step))
+        {
+            valid = false;
+            break;
+        }
+
+        // fields which a command doesn't use are zero, so all of them are checked
+        float numbers[] = { record.radius, record.position[0], record.position[1], record.orientation, record.velocity[0], record.velocity[1],
+            record.angularVelocity, record.staticFriction, record.kineticFriction, record.restitution, record.density,
+            record.vector[0], record.vector[1], record.contactVector[0], record.contactVector[1], record.commandAngularVelocity };
+        if (!allFinite(numbers, sizeof(numbers) / sizeof(numbers[0])) ||
+            (record.type == Command::AddBody && record.shapeType == Shape::CircleID && !(record.radius > 0.0f)))
+        {
+            valid = false;
+            break;
+        }
+
+        event.vertices.clear();
+        event.normals.clear();
+        if (record.type == Command::AddBody && record.shapeType == Shape::PolygonID)
+        {
+            if (record.vertexCount < 3 || record.vertexCount > MaxPolyVertexCount)
+            {
+                valid = false;
+                break;
+            }
+
+            float values[4 * MaxPolyVertexCount];
+            if (fread(values, 4 * sizeof(float), record.vertexCount, file) != record.vertexCount)
+                break;
+            if (!allFinite(values, 4 * record.vertexCount))
+            {
+                valid = false;
+                break;
+            }
+            for (uint32_t i = 0; i < record.vertexCount; i++)
+            {
+                event.vertices.push_back(Vector2D(values[4 * i], values[4 * i + 1]));
+                event.normals.push_back(Vector2D(values[4 * i + 2], values[4 * i + 3]));
+            }
+        }
+        else if (record.type == Command::AddBody && record.shapeType == Shape::ChainID)
+        {
+            // chains may be long, so their vertices are read one by one
+            float values[4];
+            bool finite = true;
+            for (uint32_t i = 0; i < record.vertexCount && fread(values, sizeof(values), 1, file) == 1; i++)
+            {
+                finite = finite && allFinite(values, 2);
+                event.vertices.push_back(Vector2D(values[0], values[1]));
+                event.normals.push_back(Vector2D(values[2], values[3]));
+            }
+            if (event.vertices.size() != record.vertexCount)
+                break;
+            if (!finite)
+            {
+                valid = false;
+                break;
+            }
+
+            Chain* chain = record.isLoop > 1 ? nullptr : Chain::FromStored(event.vertices.data(), (int)event.vertices.size(), record.isLoop != 0);
+            if (!chain)
+            {
+                valid = false;
+                break;
+            }
+            delete chain;
+        }
+        else if (record.type == Command::AddBody && record.shapeType == Shape::CapsuleID)
+        {
+            float values[8];
+            if (record.vertexCount != 2)
+            {
+                valid = false;
+                break;
+            }
+            if (fread(values, 4 * sizeof(float), 2, file) != 2)
+                break;
+            // the second end of the core is at halfLength on the x axis
+            if (!(record.radius > 0.0f) || !std::isfinite(values[4]) || !(values[4] > EPSILON))
+            {
+                valid = false;
+                break;
+            }
+            event.vertices.push_back(Vector2D(values[0], values[1]));
+            event.vertices.push_back(Vector2D(values[4], values[5]));
+        }
+        else if (record.type == Command::AddBody && record.shapeType != Shape::CircleID)
+        {
+            valid = false;
+            break;
+        }
+
+        events.push_back(event);
+    }
+
+    fclose(file);
+    if (!valid)
+        events.clear();
+    return valid;
+}
+
+unsigned int InputReplay::GetSeed() const
+{
+    return header.seed;
+}
+
+WorldSettings InputReplay::GetSettings() const
+{
+    WorldSettings settings;
+    settings.gravity = Vector2D(header.gravity[0], header.gravity[1]);
+    settings.dt = header.dt;
+    settings.iterations = header.iterations;
+    settings.penetrationAllowance = header.penetrationAllowance;
+    settings.penetrationPercent = header.penetrationPercent;
+    return settings;
+}
+
+unsigned long long InputReplay::GetStepCount() const
+{
+    return events.empty() ? 0 : events.back().record.step + 1;
+}
+
+void InputReplay::Step(World& world)
+{
+    // commands go through the queue like in the recorded session, so they are applied in the same order
+    while (nextEvent < events.size() && events[nextEvent].record.step <= world.stepIndex)
+    {
+        const InputEvent& event = events[nextEvent++];
+        const InputRecord& record = event.record;
+
+        switch (record.type)
+        {
+        case Command::AddBody:
+        {
+            BodyDefinition definition;
+            definition.position = Vector2D(record.position[0], record.position[1]);
+            definition.orientation = record.orientation;
+            definition.velocity = Vector2D(record.velocity[0], record.velocity[1]);
+            definition.angularVelocity = record.angularVelocity;
+            definition.staticFriction = record.staticFriction;
+            definition.kineticFriction = record.kineticFriction;
+            definition.restitution = record.restitution;
+            definition.density = record.density;
+            definition.isStatic = record.isStatic != 0;
+            definition.color.red = record.color[0];
+            definition.color.green = record.color[1];
+            definition.color.blue = record.color[2];
+            definition.filter.category = record.filterCategory;
+            definition.filter.mask = record.filterMask;
+            definition.filter.group = record.filterGroup;
+            definition.isSensor = record.isSensor != 0;
+
+            if (record.shapeType == Shape::CircleID)
+            {
+                Circle circle(record.radius);
+                world.commands.Add(&circle, definition);
+            }
+            else if (record.shapeType == Shape::CapsuleID)
+            {
+                Capsule capsule(event.vertices[1].x, record.radius);
+                world.commands.Add(&capsule, definition);
+            }
+            else if (record.shapeType == Shape::ChainID)
+            {
+                // normals of chains are calculated from vertices in the same way, so the chain is identical too
+                Chain* chain = Chain::FromStored(event.vertices.data(), (int)event.vertices.size(), record.isLoop != 0);
+                world.commands.Add(chain, definition);
+                delete chain;
+            }
+            else
+            {
+                // the polygon is rebuilt from its logged vertices and normals instead of the constructor,
+                // so it is identical bit by bit
+                Poly poly;
+                poly.verticesCount = (int)event.vertices.size();
+                for (unsigned int i = 0; i < event.vertices.size(); i++)
+                {
+                    poly.verticesArray[i] = event.vertices[i];
+                    poly.normalVectors[i] = event.normals[i];
+                }
+                world.commands.Add(&poly, definition);
+            }
+        }
+        break;
+        case Command::RemoveBody:
+            world.commands.Remove(record.bodyId);
+            break;
+        case Command::ApplyImpulse:
+            world.commands.ApplyImpulse(record.bodyId, Vector2D(record.vector[0], record.vector[1]),
+                Vector2D(record.contactVector[0], record.contactVector[1]));
+            break;
+        case Command::SetVelocity:
+            world.commands.SetVelocity(record.bodyId, Vector2D(record.vector[0], record.vector[1]), record.commandAngularVelocity);
+            break;
+        case Command::SetFilter:
+        {
+            CollisionFilter filter;
+            filter.category = record.filterCategory;
+            filter.mask = record.filterMask;
+            filter.group = record.filterGroup;
+            world.commands.SetFilter(record.bodyId, filter);
+        }
+        break;
+        }
+    }
+
+    world.Step();
+}
+
+const std::vector<InputEvent>& InputReplay::GetEvents() const
+{
+    return events;
+}
@@ -0,0 +1,162 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#ifndef INPUTLOG_H
+#define INPUTLOG_H
+
+#include <cstdint>
+#include <cstdio>
+#include <chrono>
+
+#include "Constans.h"
+
+class World;
+struct Command;
+
+// binary input log format
+// the header is followed by one record for every command applied by the world, in order of applying;
+// a record of AddBody is followed by the vertices and face normals of its polygon or chain, or the ends of the core of its capsule
+//
+//   InputLogHeader
+//   InputRecord, float[4 * vertexCount]
+//   InputRecord, float[4 * vertexCount]
+//   ...
+//
+// commands are logged with the index of the step which applied them, so replaying them before
+// the same steps of a world with the same settings repeats the session exactly
+
+const char inputLogMagic[8] = { 'R', 'B', '2', 'D', 'I', 'N', 'P', 'T' };
+const uint32_t inputLogVersion = 4;
+
+
+struct InputLogHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;             // worldFileByteOrder as written by the recording machine
+    uint32_t seed;                  // seed of rand() of the recorded session
+    float gravity[2];
+    float dt;
+    uint32_t iterations;
+    float penetrationAllowance;
+    float penetrationPercent;
+    uint32_t reserved;
+};
+
+
+struct InputRecord
+{
+    uint64_t step;                  // index of the step which applied the command
+    double time;                    // in [ second ] since the log was opened
+
+    uint32_t type;                  // Command::Type
+    uint32_t bodyId;
+
+    // AddBody - shape
+    uint32_t shapeType;             // Shape::ID
+    uint32_t vertexCount;           // polygons, chains, capsules
+    uint32_t isLoop;                // chains - whether the last vertex is connected with the first one
+    float radius;                   // circles, capsules
+
+    // AddBody - definition
+    float position[2];
+    float orientation;
+    float velocity[2];
+    float angularVelocity;
+    float staticFriction;
+    float kineticFriction;
+    float restitution;
+    float density;
+    uint32_t isStatic;
+    float color[3];
+
+    // ApplyImpulse, SetVelocity
+    float vector[2];
+    float contactVector[2];
+    float commandAngularVelocity;
+
+    // AddBody - definition, SetFilter
+    uint16_t filterCategory;
+    uint16_t filterMask;
+    int16_t filterGroup;
+    uint16_t isSensor;              // AddBody
+    uint32_t reserved;
+};
+
+
+// logged command together with its polygon
+struct InputEvent
+{
+    InputRecord record;
+    std::vector<Vector2D> vertices;
+    std::vector<Vector2D> normals;
+};
+
+
+// InputLog class - writes commands applied by a world, so the session can be replayed headless
+// records are flushed after every step which applied commands, so an interrupted session keeps them
+class InputLog
+{
+public:
+    // constructor
+    InputLog();
+
+    // destructor - closes the file
+    ~InputLog();
+
+    // creates the file and writes the header; returns false if the file can't be written
+    // path - path of the file
+    // seed - seed of rand() which the session uses to spawn bodies
+    // settings - physical parameters of the recorded world
+    bool Open(const char* path, unsigned int seed, const WorldSettings& settings);
+
+    // closes the file
+    void Close();
+
+    // writes a command; called by the world right before applying it
+    // step - index of the step which applies the command
+    // command - applied command
+    void Record(unsigned long long step, const Command& command);
+
+    // writes records of the current step to the disk
+    void Flush();
+
+private:
+    FILE* file;
+    bool written;
+    std::chrono::steady_clock::time_point start;
+};
+
+
+// InputReplay class - repeats a logged session on a world step by step
+class InputReplay
+{
+public:
+    // reads a whole log; returns false if the file is missing or invalid
+    // path - path of the file
+    bool Open(const char* path);
+
+    // returns seed of rand() of the recorded session
+    unsigned int GetSeed() const;
+
+    // returns physical parameters of the recorded world
+    WorldSettings GetSettings() const;
+
+    // returns number of steps which the replay needs to apply all commands
+    unsigned long long GetStepCount() const;
+
+    // queues commands of the next step of the world and carries out the step
+    // world - world created with GetSettings which was stepped only by this replay
+    void Step(World& world);
+
+    // returns logged commands
+    const std::vector<InputEvent>& GetEvents() const;
+
+private:
+    InputLogHeader header;
+    std::vector<InputEvent> events;
+    unsigned int nextEvent = 0;
+};
+
+#endif // INPUTLOG_H
@@ -0,0 +1,224 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#include "IncludesManager.h"
+
+// system and queue index of the current thread
+static thread_local const JobSystem* currentSystem = nullptr;
+static thread_local unsigned int currentIndex = 0;
+
+
+JobSystem::JobSystem(unsigned int threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    queuedTasks = 0;
+    quit = false;
+
+    for (unsigned int i = 0; i < threadCount; i++)
+        queues.push_back(new Queue());
+
+    // the calling thread is also executing tasks, so it needs one thread less
+    for (unsigned int i = 1; i < threadCount; i++)
+        workers.emplace_back(&JobSystem::Work, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        quit = true;
+    }
+    wakeUp.notify_all();
+
+    for (unsigned int i = 0; i < workers.size(); i++)
+        workers[i].join();
+
+    for (unsigned int i = 0; i < queues.size(); i++)
+        delete queues[i];
+}
+
+unsigned int JobSystem::ThreadCount() const
+{
+    return (unsigned int)queues.size();
+}
+
+unsigned int JobSystem::ThreadIndex() const
+{
+    return currentSystem == this ? currentIndex : 0;
+}
+
+void JobSystem::ParallelFor(unsigned int count, unsigned int grainSize, const RangeFunction& function)
+{
+    if (count == 0)
+        return;
+    if (grainSize == 0)
+        grainSize = 1;
+
+    // the whole range fits in one chunk or there is nobody to share it with
+    if (workers.empty() || count <= grainSize)
+    {
+        for (unsigned int begin = 0; begin < count; begin += grainSize)
+            function(begin, std::min(count, begin + grainSize));
+        return;
+    }
+
+    std::atomic<int> counter(0);
+    for (unsigned int begin = 0; begin < count; begin += grainSize)
+    {
+        unsigned int end = std::min(count, begin + grainSize);
+        Submit([&function, begin, end] { function(begin, end); }, &counter);
+    }
+    Wait(&counter);
+}
+
+JobSystem& JobSystem::Serial()
+{
+    static JobSystem serial(1);
+    return serial;
+}
+
+void JobSystem::Submit(const std::function<void()>& function, std::atomic<int>* counter)
+{
+    counter->fetch_add(1);
+
+    Queue* queue = queues[ThreadIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->tasks.push_back(Task{ function, counter });
+    }
+    queuedTasks.fetch_add(1);
+
+    if (!workers.empty())
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wakeUp.notify_one();
+    }
+}
+
+void JobSystem::Wait(std::atomic<int>* counter)
+{
+    unsigned int threadIndex = ThreadIndex();
+    while (counter->load() > 0)
+    {
+        if (!TryRun(threadIndex))
+            std::this_thread::yield();
+    }
+}
+
+bool JobSystem::TryRun(unsigned int threadIndex)
+{
+    Task task;
+    bool found = false;
+
+    // the newest task from own queue - its data is probably still in cache
+    {
+        Queue* queue = queues[threadIndex];
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (!queue->tasks.empty())
+        {
+            task = std::move(queue->tasks.back());
+            queue->tasks.pop_back();
+            found = true;
+        }
+    }
+
+    // the oldest task from other queues - it is usually the biggest piece of work
+    for (unsigned int i = 1; !found && i < queues.size(); i++)
+    {
+        Queue* queue = queues[(threadIndex + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (!queue->tasks.empty())
+        {
+            task = std::move(queue->tasks.front());
+            queue->tasks.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found)
+        return false;
+
+    queuedTasks.fetch_sub(1);
+    task.function();
+    task.counter->fetch_sub(1);
+    return true;
+}
+
+void JobSystem::Work(unsigned int threadIndex)
+{
+    currentSystem = this;
+    currentIndex = threadIndex;
+
+    while (true)
+    {
+        if (TryRun(threadIndex))
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this] { return quit || queuedTasks.load() > 0; });
+        if (quit)
+            return;
+    }
+}
+
+
+int JobGraph::Add(const std::function<void()>& function)
+{
+    Node node;
+    node.function = function;
+    nodes.push_back(node);
+    return (int)nodes.size() - 1;
+}
+
+void JobGraph::Depend(int before, int after)
+{
+    // adding order is a valid execution order, which also rules out cycles
+    assert(before < after);
+    nodes[before].successors.push_back(after);
+    nodes[after].dependencies++;
+}
+
+void JobGraph::Clear()
+{
+    nodes.clear();
+}
+
+void JobGraph::Run(JobSystem& jobs)
+{
+    if (jobs.workers.empty())
+    {
+        for (unsigned int i = 0; i < nodes.size(); i++)
+            nodes[i].function();
+        return;
+    }
+
+    remaining.reset(new std::atomic<int>[nodes.size()]);
+    for (unsigned int i = 0; i < nodes.size(); i++)
+        remaining[i] = nodes[i].dependencies;
+
+    std::atomic<int> counter(0);
+    for (unsigned int i = 0; i < nodes.size(); i++)
+    {
+        if (nodes[i].dependencies == 0)
+            Launch(jobs, i, &counter);
+    }
+    jobs.Wait(&counter);
+}
+
+void JobGraph::Launch(JobSystem& jobs, int node, std::atomic<int>* counter)
+{
+    jobs.Submit([this, &jobs, node, counter]
+    {
+        nodes[node].function();
+
+        for (unsigned int i = 0; i < nodes[node].successors.size(); i++)
+        {
+            int successor = nodes[node].successors[i];
+            if (remaining[successor].fetch_sub(1) == 1)
+                Launch(jobs, successor, counter);
+        }
+    }, counter);
+}
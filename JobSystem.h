@@ -0,0 +1,118 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <functional>
+#include <deque>
+#include <memory>
+
+// function executed over range [ begin, end ) of elements
+typedef std::function<void(unsigned int begin, unsigned int end)> RangeFunction;
+
+
+// JobSystem class - work-stealing task scheduler
+// every thread owns a queue of tasks; it takes new tasks from the back of own queue
+// and when its queue is empty it steals the oldest tasks from the front of other queues
+// a thread waiting for its tasks executes other tasks instead of sleeping, so jobs can be nested
+class JobSystem
+{
+public:
+    // constructor
+    // threadCount - number of threads executing tasks ( calling thread included ); 0 means one per hardware thread
+    // with threadCount equal to 1 there are no worker threads and every job runs in order on the calling thread
+    JobSystem(unsigned int threadCount);
+
+    // destructor - stops and joins worker threads
+    ~JobSystem();
+
+    // returns number of threads executing tasks
+    unsigned int ThreadCount() const;
+
+    // returns index of the current thread in [ 0, ThreadCount() ); threads outside the system share index 0
+    unsigned int ThreadIndex() const;
+
+    // splits [ 0, count ) into chunks of grainSize elements, executes function on every chunk and blocks until all are done
+    // count - number of elements
+    // grainSize - number of elements in one chunk
+    // function - function called with range of each chunk
+    void ParallelFor(unsigned int count, unsigned int grainSize, const RangeFunction& function);
+
+    // returns shared system without worker threads
+    static JobSystem& Serial();
+
+private:
+    friend class JobGraph;
+
+    struct Task
+    {
+        std::function<void()> function;
+        std::atomic<int>* counter;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<Queue*> queues;
+    std::atomic<int> queuedTasks;
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    bool quit;
+
+    // pushes task to the queue of the current thread; counter is decremented when task is done
+    void Submit(const std::function<void()>& function, std::atomic<int>* counter);
+
+    // executes tasks until counter drops to zero
+    void Wait(std::atomic<int>* counter);
+
+    // takes one task from own queue or steals it from another queue
+    bool TryRun(unsigned int threadIndex);
+
+    // worker thread loop
+    void Work(unsigned int threadIndex);
+};
+
+
+// JobGraph class - set of jobs with dependencies executed on JobSystem
+class JobGraph
+{
+public:
+    // adds a new job and returns its index
+    // function - work of the job
+    int Add(const std::function<void()>& function);
+
+    // job after can't start until job before is done; jobs have to be added in dependency order
+    // before - index of job which has to finish first
+    // after - index of dependent job
+    void Depend(int before, int after);
+
+    // removes all jobs
+    void Clear();
+
+    // executes all jobs and blocks until they are done
+    // with a serial job system jobs run in the order they were added to the graph
+    // jobs - system executing jobs
+    void Run(JobSystem& jobs);
+
+private:
+    struct Node
+    {
+        std::function<void()> function;
+        std::vector<int> successors;
+        int dependencies = 0;
+    };
+
+    std::vector<Node> nodes;
+    std::unique_ptr<std::atomic<int>[]> remaining;
+
+    // submits job and after it is done submits successors whose dependencies are done
+    void Launch(JobSystem& jobs, int node, std::atomic<int>* counter);
+};
+
+#endif // JOBSYSTEM_H
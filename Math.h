@@ -213,6 +213,101 @@ public:
     }
 };
 
+// AABB math class - axis aligned bounding box
+class AABB
+{
+public:
+    Vector2D min;
+    Vector2D max;
+
+    // constructor v1
+    AABB()
+    {
+    }
+
+    // constructor v2
+    // _min - corner with the smallest coordinates
+    // _max - corner with the largest coordinates
+    AABB(const Vector2D& _min, const Vector2D& _max)
+    {
+        min = _min;
+        max = _max;
+    }
+
+    // returns whether boxes have a common part
+    bool Overlaps(const AABB& box) const
+    {
+        return min.x <= box.max.x && box.min.x <= max.x && min.y <= box.max.y && box.min.y <= max.y;
+    }
+
+    // returns whether the whole box is inside this box
+    bool Contains(const AABB& box) const
+    {
+        return min.x <= box.min.x && min.y <= box.min.y && box.max.x <= max.x && box.max.y <= max.y;
+    }
+
+    // returns whether point is inside the box
+    bool Contains(const Vector2D& point) const
+    {
+        return min.x <= point.x && point.x <= max.x && min.y <= point.y && point.y <= max.y;
+    }
+
+    // returns whether segment start + t * delta for t in [ 0, maxFraction ] crosses the box
+    bool IntersectsSegment(const Vector2D& start, const Vector2D& delta, float maxFraction) const
+    {
+        float lower = 0.0f;
+        float upper = maxFraction;
+        const float starts[2] = { start.x, start.y };
+        const float deltas[2] = { delta.x, delta.y };
+        const float mins[2] = { min.x, min.y };
+        const float maxs[2] = { max.x, max.y };
+        for (int axis = 0; axis < 2; axis++)
+        {
+            if (std::abs(deltas[axis]) < FLT_EPSILON)
+            {
+                // parallel to the slab
+                if (starts[axis] < mins[axis] || maxs[axis] < starts[axis])
+                    return false;
+                continue;
+            }
+
+            float inverse = 1.0f / deltas[axis];
+            float t1 = (mins[axis] - starts[axis]) * inverse;
+            float t2 = (maxs[axis] - starts[axis]) * inverse;
+            lower = std::max(lower, std::min(t1, t2));
+            upper = std::min(upper, std::max(t1, t2));
+            if (lower > upper)
+                return false;
+        }
+        return true;
+    }
+
+    // returns the smallest box containing both boxes
+    AABB Combine(const AABB& box) const
+    {
+        return AABB(Vector2D(std::min(min.x, box.min.x), std::min(min.y, box.min.y)),
+                    Vector2D(std::max(max.x, box.max.x), std::max(max.y, box.max.y)));
+    }
+
+    // returns box enlarged by margin on every side
+    AABB Extend(float margin) const
+    {
+        return AABB(Vector2D(min.x - margin, min.y - margin), Vector2D(max.x + margin, max.y + margin));
+    }
+
+    // returns box center
+    Vector2D Center() const
+    {
+        return Vector2D(0.5f * (min.x + max.x), 0.5f * (min.y + max.y));
+    }
+
+    // returns box perimeter, which is a cost of the box in the tree
+    float Perimeter() const
+    {
+        return 2.0f * ((max.x - min.x) + (max.y - min.y));
+    }
+};
+
 // return vector1 dot vector2
 inline float dot(const Vector2D& vector1, const Vector2D& vector2)
 {
@@ -243,6 +338,17 @@ inline bool equal(float number1, float number2)
     return std::abs(number1 - number2) <= EPSILON;
 }
 
+// returns whether all numbers are finite, so none of them is infinite or NaN
+// values - checked numbers
+// count - number of checked numbers
+inline bool allFinite(const float* values, int count)
+{
+    for (int i = 0; i < count; i++)
+        if (!std::isfinite(values[i]))
+            return false;
+    return true;
+}
+
 // returns random number between <_min, _max>
 inline float random(float _min, float _max)
 {
@@ -0,0 +1,348 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#include "IncludesManager.h"
+#include "NarrowphaseBenchmark.h"
+#include <cstdio>
+#include <string>
+
+// number of different pairs measured in turn; power of two, so the index is a mask
+const unsigned int narrowphaseInstances = 64;
+
+// how far from the first contact bodies of a pair are placed
+enum NarrowphaseCase
+{
+    CaseOverlapping,
+    CaseTouching,
+    CaseSeparated,
+    CaseCount
+};
+
+static const char* caseNames[CaseCount] = { "overlapping", "touching", "separated" };
+
+// number of vertices which stands for a capsule
+const int capsuleVertices = -1;
+
+// keeps results of measured calls alive, so the compiler can't remove them
+static volatile float sink;
+
+
+// pair of bodies with everything the routines need precomputed
+struct NarrowphaseInstance
+{
+    RigidBody* bodyA;
+    RigidBody* bodyB;
+    ContactPoint* point;
+
+    int referenceFace;              // polygons - face of A with the least penetration
+    Vector2D incidentFace[2];       // polygons - face of B which is clipped
+    Vector2D sideNormal;            // polygons - normal of the side plane of the reference face
+    float side;
+};
+
+
+// one measured routine with one vertex count and one case
+struct NarrowphaseResult
+{
+    const char* routine;
+    int vertices;
+    NarrowphaseCase type;
+    double nanoseconds;
+};
+
+
+// creates a body with a circle, a capsule or a regular polygon of given number of vertices ( 0 means circle )
+// returns radius of the bounding circle
+static RigidBody* CreateBody(int vertices, float& radius)
+{
+    radius = random(0.5f, 1.5f);
+    RigidBody* body;
+    if (vertices == 0)
+    {
+        Circle circle(radius);
+        body = new RigidBody(&circle, 0, 0, 0, 0, 0, 1);
+    }
+    else if (vertices == capsuleVertices)
+    {
+        float capsuleRadius = 0.4f * radius;
+        Capsule capsule(radius - capsuleRadius, capsuleRadius);
+        body = new RigidBody(&capsule, 0, 0, 0, 0, 0, 1);
+    }
+    else
+    {
+        Vector2D points[MaxPolyVertexCount];
+        for (int i = 0; i < vertices; i++)
+        {
+            float angle = 2.0f * PI * i / vertices;
+            points[i] = Vector2D(radius * std::cos(angle), radius * std::sin(angle));
+        }
+        Poly poly(points, vertices);
+        body = new RigidBody(&poly, 0, 0, 0, 0, 0, 1);
+    }
+    body->SetOrientation(random(-PI, PI));
+    return body;
+}
+
+// checks whether bodies collide
+static bool Collide(RigidBody* bodyA, RigidBody* bodyB)
+{
+    ContactPoint point(bodyA, bodyB);
+    point.Solve();
+    return point.contact_count > 0;
+}
+
+// creates a pair placed according to the case; B is moved along a random direction
+// from the center of A, and the distance of the first contact is found by bisection
+static NarrowphaseInstance CreateInstance(int verticesA, int verticesB, NarrowphaseCase type)
+{
+    NarrowphaseInstance instance;
+    float radiusA, radiusB;
+    instance.bodyA = CreateBody(verticesA, radiusA);
+    instance.bodyB = CreateBody(verticesB, radiusB);
+
+    float angle = random(-PI, PI);
+    Vector2D direction(std::cos(angle), std::sin(angle));
+
+    float inside = 0.0f;
+    float outside = radiusA + radiusB + 0.01f;
+    for (int i = 0; i < 40; i++)
+    {
+        float middle = 0.5f * (inside + outside);
+        instance.bodyB->position = direction * middle;
+        if (Collide(instance.bodyA, instance.bodyB))
+            inside = middle;
+        else
+            outside = middle;
+    }
+
+    float distance = type == CaseOverlapping ? 0.5f * outside : (type == CaseTouching ? inside : 1.1f * outside);
+    instance.bodyB->position = direction * distance;
+    instance.point = new ContactPoint(instance.bodyA, instance.bodyB);
+
+    // inputs of the polygon helpers are prepared the same way as in PolygonToPolygon
+    instance.referenceFace = 0;
+    if (verticesA > 0 && verticesB > 0)
+    {
+        Poly* A = (Poly*)instance.bodyA->shape;
+        Poly* B = (Poly*)instance.bodyB->shape;
+        FindAxisLeastPenetration(&instance.referenceFace, A, B);
+        FindIncidentFace(instance.incidentFace, A, B, instance.referenceFace);
+
+        int next = instance.referenceFace + 1 == A->verticesCount ? 0 : instance.referenceFace + 1;
+        Vector2D v1 = A->orientation * A->verticesArray[instance.referenceFace] + instance.bodyA->position;
+        Vector2D v2 = A->orientation * A->verticesArray[next] + instance.bodyA->position;
+        instance.sideNormal = v2 - v1;
+        instance.sideNormal.normalize();
+        instance.side = -dot(instance.sideNormal, v1);
+    }
+    return instance;
+}
+
+static void DestroyInstance(NarrowphaseInstance& instance)
+{
+    delete instance.point;
+    delete instance.bodyA;
+    delete instance.bodyB;
+}
+
+// calls function on instances in turn until minSeconds pass; returns nanoseconds per call
+template <typename Function>
+static double Measure(Function call, double minSeconds)
+{
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    unsigned long long calls = narrowphaseInstances;
+    for (;;)
+    {
+        long long start = Profiler::Now();
+        for (unsigned long long i = 0; i < calls; i++)
+            call((unsigned int)i & (narrowphaseInstances - 1));
+        long long end = Profiler::Now();
+
+        double seconds = (end - start) / (double)frequency.QuadPart;
+        if (seconds >= minSeconds)
+            return seconds * 1e9 / calls;
+        calls *= 2;
+    }
+}
+
+// measures all routines which take given shapes ( 0 vertices means circle, capsuleVertices capsule )
+static void MeasureShapes(int verticesA, int verticesB, int vertices, double minSeconds, std::vector<NarrowphaseResult>& results)
+{
+    for (int type = 0; type < CaseCount; type++)
+    {
+        std::vector<NarrowphaseInstance> instances;
+        for (unsigned int i = 0; i < narrowphaseInstances; i++)
+            instances.push_back(CreateInstance(verticesA, verticesB, (NarrowphaseCase)type));
+        NarrowphaseInstance* pairs = instances.data();
+
+        NarrowphaseResult result;
+        result.vertices = vertices;
+        result.type = (NarrowphaseCase)type;
+
+        if (verticesA == capsuleVertices)
+        {
+            void (*routine)(ContactPoint*, RigidBody*, RigidBody*) = CapsuleToPolygon;
+            result.routine = "CapsuleToPolygon";
+            if (verticesB == 0)
+            {
+                routine = CapsuleToCircle;
+                result.routine = "CapsuleToCircle";
+            }
+            else if (verticesB == capsuleVertices)
+            {
+                routine = CapsuleToCapsule;
+                result.routine = "CapsuleToCapsule";
+            }
+            result.nanoseconds = Measure([&](unsigned int i)
+            {
+                routine(pairs[i].point, pairs[i].bodyA, pairs[i].bodyB);
+                sink = pairs[i].point->penetration;
+            }, minSeconds);
+            results.push_back(result);
+        }
+        else if (verticesA == 0 && verticesB == 0)
+        {
+            result.routine = "CircleToCircle";
+            result.nanoseconds = Measure([&](unsigned int i)
+            {
+                CircleToCircle(pairs[i].point, pairs[i].bodyA, pairs[i].bodyB);
+                sink = pairs[i].point->penetration;
+            }, minSeconds);
+            results.push_back(result);
+        }
+        else if (verticesA == 0)
+        {
+            result.routine = "CircleToPolygon";
+            result.nanoseconds = Measure([&](unsigned int i)
+            {
+                CircleToPolygon(pairs[i].point, pairs[i].bodyA, pairs[i].bodyB);
+                sink = pairs[i].point->penetration;
+            }, minSeconds);
+            results.push_back(result);
+        }
+        else if (verticesB == 0)
+        {
+            result.routine = "PolygonToCircle";
+            result.nanoseconds = Measure([&](unsigned int i)
+            {
+                PolygonToCircle(pairs[i].point, pairs[i].bodyA, pairs[i].bodyB);
+                sink = pairs[i].point->penetration;
+            }, minSeconds);
+            results.push_back(result);
+        }
+        else
+        {
+            result.routine = "PolygonToPolygon";
+            result.nanoseconds = Measure([&](unsigned int i)
+            {
+                PolygonToPolygon(pairs[i].point, pairs[i].bodyA, pairs[i].bodyB);
+                sink = pairs[i].point->penetration;
+            }, minSeconds);
+            results.push_back(result);
+
+            result.routine = "FindAxisLeastPenetration";
+            result.nanoseconds = Measure([&](unsigned int i)
+            {
+                int face;
+                sink = FindAxisLeastPenetration(&face, (Poly*)pairs[i].bodyA->shape, (Poly*)pairs[i].bodyB->shape) + face;
+            }, minSeconds);
+            results.push_back(result);
+
+            result.routine = "FindIncidentFace";
+            result.nanoseconds = Measure([&](unsigned int i)
+            {
+                Vector2D face[2];
+                FindIncidentFace(face, (Poly*)pairs[i].bodyA->shape, (Poly*)pairs[i].bodyB->shape, pairs[i].referenceFace);
+                sink = face[0].x;
+            }, minSeconds);
+            results.push_back(result);
+
+            result.routine = "Clip";
+            result.nanoseconds = Measure([&](unsigned int i)
+            {
+                Vector2D face[2] = { pairs[i].incidentFace[0], pairs[i].incidentFace[1] };
+                sink = (float)Clip(-pairs[i].sideNormal, pairs[i].side, face) + face[1].x;
+            }, minSeconds);
+            results.push_back(result);
+        }
+
+        for (unsigned int i = 0; i < instances.size(); i++)
+            DestroyInstance(instances[i]);
+    }
+}
+
+int RunNarrowphaseBenchmark(int argc, char** argv)
+{
+    std::vector<int> vertexCounts = { 3, 4, 5, 6, 8, 12, 16, 24, 32, 48, 64, 96, MaxPolyVertexCount };
+    double minSeconds = 0.05;
+    unsigned int seed = 1;
+    std::string out;
+
+    for (int i = 0; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (i + 1 >= argc)
+            return 1;
+        const char* value = argv[++i];
+
+        if (option == "--vertices")
+        {
+            vertexCounts.clear();
+            for (const char* c = value; *c; )
+            {
+                char* end;
+                long count = strtol(c, &end, 10);
+                if (end == c || count < 3 || count > MaxPolyVertexCount)
+                    return 1;
+                vertexCounts.push_back((int)count);
+                c = *end == ',' ? end + 1 : end;
+            }
+        }
+        else if (option == "--min-time")
+            minSeconds = atof(value);
+        else if (option == "--seed")
+            seed = (unsigned int)strtoul(value, nullptr, 10);
+        else if (option == "--out")
+            out = value;
+        else
+            return 1;
+    }
+
+    srand(seed);
+    std::vector<NarrowphaseResult> results;
+    MeasureShapes(0, 0, 0, minSeconds, results);
+    MeasureShapes(capsuleVertices, 0, 0, minSeconds, results);
+    MeasureShapes(capsuleVertices, capsuleVertices, 0, minSeconds, results);
+    for (unsigned int i = 0; i < vertexCounts.size(); i++)
+    {
+        int n = vertexCounts[i];
+        MeasureShapes(0, n, n, minSeconds, results);
+        MeasureShapes(n, 0, n, minSeconds, results);
+        MeasureShapes(n, n, n, minSeconds, results);
+        MeasureShapes(capsuleVertices, n, n, minSeconds, results);
+        fprintf(stderr, "vertices %d done\n", n);
+    }
+
+    FILE* file = stdout;
+    if (!out.empty() && fopen_s(&file, out.c_str(), "w") != 0)
+    {
+        fprintf(stderr, "can't write %s\n", out.c_str());
+        return 1;
+    }
+
+    fprintf(file, "{\n  \"minSeconds\": %.3f,\n  \"seed\": %u,\n  \"instances\": %u,\n  \"results\": [", minSeconds, seed, narrowphaseInstances);
+    for (unsigned int i = 0; i < results.size(); i++)
+    {
+        const NarrowphaseResult& r = results[i];
+        fprintf(file, "%s\n    {\"routine\": \"%s\", \"vertices\": %d, \"case\": \"%s\", \"nsPerCall\": %.3f}",
+            i ? "," : "", r.routine, r.vertices, caseNames[r.type], r.nanoseconds);
+    }
+    fprintf(file, "\n  ]\n}\n");
+
+    if (file != stdout)
+        fclose(file);
+    return 0;
+}
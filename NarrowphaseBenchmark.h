@@ -0,0 +1,14 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#ifndef NARROWPHASEBENCHMARK_H
+#define NARROWPHASEBENCHMARK_H
+
+// measures every routine of Collision.cpp in isolation and writes nanoseconds per call as JSON
+// usage: Benchmark --narrowphase [--vertices 3,4,8,128] [--min-time 0.05] [--seed 1] [--out results.json]
+// argc, argv - command line without the program name
+// returns exit code of the program
+int RunNarrowphaseBenchmark(int argc, char** argv);
+
+#endif // NARROWPHASEBENCHMARK_H
@@ -8,7 +8,7 @@
 #include "IncludesManager.h"
 
 // integrates forces
-void IntegrateForce(RigidBody* body, float dt)
+void IntegrateForce(RigidBody* body, const Vector2D& gravity, float dt)
 {
     if (body->inverseMass == 0.0f)
         return;
@@ -18,7 +18,7 @@ void IntegrateForce(RigidBody* body, float dt)
 }
 
 // integrates velocities
-void IntegrateVelocity(RigidBody* body, float dt)
+void IntegrateVelocity(RigidBody* body, const Vector2D& gravity, float dt)
 {
     if (body->inverseMass == 0.0f)
         return;
@@ -26,7 +26,7 @@ void IntegrateVelocity(RigidBody* body, float dt)
     body->position += body->velocity * dt;
     body->orientation += body->angularVelocity * dt;
     body->SetOrientation(body->orientation);
-    IntegrateForce(body, dt);
+    IntegrateForce(body, gravity, dt);
 }
 
 #endif // PHYSICS_H
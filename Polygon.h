@@ -104,10 +104,6 @@ public:
 
     Shape* Copy() const
     {
-        Vector2D* vertices = new Vector2D[verticesCount];
-        for (int i = 0; i < verticesCount; i++)
-            vertices[i] = verticesArray[i];
-            
         Poly* poly = new Poly();
         poly->orientation = orientation;
         for (int i = 0; i < verticesCount; i++)
@@ -125,7 +121,7 @@ public:
         float inertialMoment = 0.0;
 
         // area = 1/2 * | (x1*y2 - y1*x2) + (x2*y3 - y2*x3) + ... + (xn*y1 - yn*x1) |
-        for (int i = 0; i < verticesCount; i++)
+        for (int i = 0; i < verticesCount - 1; i++)
         {
             area += verticesArray[i].x * verticesArray[i + 1].y;
             area -= verticesArray[i].y * verticesArray[i + 1].x;
@@ -166,6 +162,75 @@ public:
         orientation = Matrix2X2(radians);
     }
 
+    AABB GetAABB() const
+    {
+        Vector2D v = orientation * verticesArray[0];
+        AABB box(v, v);
+        for (int i = 1; i < verticesCount; i++)
+        {
+            v = orientation * verticesArray[i];
+            box.min.x = std::min(box.min.x, v.x);
+            box.min.y = std::min(box.min.y, v.y);
+            box.max.x = std::max(box.max.x, v.x);
+            box.max.y = std::max(box.max.y, v.y);
+        }
+        box.min += body->position;
+        box.max += body->position;
+        return box;
+    }
+
+    bool RayCast(const Vector2D& start, const Vector2D& delta, float maxFraction, float& fraction, Vector2D& normal) const
+    {
+        // the segment is clipped by half planes of all faces in coordinates of the polygon
+        Matrix2X2 inverse = orientation.transpose();
+        Vector2D localStart = inverse * (start - body->position);
+        Vector2D localDelta = inverse * delta;
+
+        float lower = 0.0f;
+        float upper = maxFraction;
+        int face = -1;
+        for (int i = 0; i < verticesCount; i++)
+        {
+            float numerator = dot(normalVectors[i], verticesArray[i] - localStart);
+            float denominator = dot(normalVectors[i], localDelta);
+            if (denominator == 0.0f)
+            {
+                if (numerator < 0.0f)
+                    return false;
+            }
+            else if (denominator < 0.0f && numerator < lower * denominator)
+            {
+                // the segment enters the half plane
+                lower = numerator / denominator;
+                face = i;
+            }
+            else if (denominator > 0.0f && numerator < upper * denominator)
+            {
+                // the segment leaves the half plane
+                upper = numerator / denominator;
+            }
+
+            if (upper < lower)
+                return false;
+        }
+
+        if (face < 0)
+            return false;
+
+        fraction = lower;
+        normal = orientation * normalVectors[face];
+        return true;
+    }
+
+    bool Contains(const Vector2D& point) const
+    {
+        Vector2D local = orientation.transpose() * (point - body->position);
+        for (int i = 0; i < verticesCount; i++)
+            if (dot(normalVectors[i], local - verticesArray[i]) > 0.0f)
+                return false;
+        return true;
+    }
+
     void Draw() const
     {
         glColor3f(body->bodyColor.red, body->bodyColor.green, body->bodyColor.blue);
@@ -178,6 +243,19 @@ public:
         glEnd();
     }
 
+    void DrawAt(const Vector2D& position, float radians, const Color& color) const
+    {
+        Matrix2X2 rotation(radians);
+        glColor3f(color.red, color.green, color.blue);
+        glBegin(GL_POLYGON);
+        for (int i = 0; i < verticesCount; i++)
+        {
+            Vector2D v = position + rotation * verticesArray[i];
+            glVertex2f(v.x, v.y);
+        }
+        glEnd();
+    }
+
     int GetType() const
     {
         return PolygonID;
@@ -0,0 +1,143 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#include "IncludesManager.h"
+
+static const char* phaseNames[PhaseCount] = {
+    "Step",
+    "Commands",
+    "Broadphase",
+    "Pairs",
+    "Narrowphase",
+    "Sensors",
+    "PrepareContacts",
+    "IntegrateForces",
+    "Solve",
+    "ContactEvents",
+    "IntegrateVelocities",
+    "CorrectPositions",
+    "ClearForces"
+};
+
+static const char* counterNames[CounterCount] = {
+    "PairsTested",
+    "ContactsGenerated",
+    "SolverIterations",
+    "BodiesIntegrated"
+};
+
+
+Profiler::Profiler()
+{
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    millisecondsPerTick = 1000.0 / (double)frequency.QuadPart;
+
+    Reset();
+    BeginStep();
+}
+
+void Profiler::BeginStep()
+{
+    memset(currentTimes, 0, sizeof(currentTimes));
+    memset(currentCounters, 0, sizeof(currentCounters));
+    stepStart = Now();
+}
+
+void Profiler::EndStep()
+{
+    AddTime(PhaseStep, stepStart, Now());
+
+    for (unsigned int i = 0; i < PhaseCount; i++)
+        times[i][next] = (float)(currentTimes[i] * millisecondsPerTick);
+    for (unsigned int i = 0; i < CounterCount; i++)
+        counters[i][next] = (float)currentCounters[i];
+
+    next = (next + 1) % profileWindow;
+    if (count < profileWindow)
+        count++;
+}
+
+void Profiler::AddTime(ProfilePhase phase, long long start, long long end)
+{
+    currentTimes[phase] += end - start;
+
+#if defined(RIGIDBODY_TRACE)
+    if (TraceRecorder::IsRecording())
+        TraceRecorder::Add(phaseNames[phase], start, end);
+#endif
+}
+
+void Profiler::Count(ProfileCounter counter, unsigned int value)
+{
+    currentCounters[counter] = value;
+}
+
+ProfileStats Profiler::GetStats(ProfilePhase phase) const
+{
+    return Calculate(times[phase]);
+}
+
+ProfileStats Profiler::GetStats(ProfileCounter counter) const
+{
+    return Calculate(counters[counter]);
+}
+
+float Profiler::GetLast(ProfilePhase phase) const
+{
+    if (count == 0)
+        return 0.0f;
+    return times[phase][(next + profileWindow - 1) % profileWindow];
+}
+
+unsigned int Profiler::StepCount() const
+{
+    return count;
+}
+
+void Profiler::Reset()
+{
+    next = 0;
+    count = 0;
+}
+
+const char* Profiler::GetName(ProfilePhase phase)
+{
+    return phaseNames[phase];
+}
+
+const char* Profiler::GetName(ProfileCounter counter)
+{
+    return counterNames[counter];
+}
+
+long long Profiler::Now()
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+}
+
+ProfileStats Profiler::Calculate(const float* values) const
+{
+    ProfileStats stats;
+    if (count == 0)
+        return stats;
+
+    // the window isn't full until profileWindow steps, so it is filled from index 0
+    float sorted[profileWindow];
+    memcpy(sorted, values, count * sizeof(float));
+    std::sort(sorted, sorted + count);
+
+    double sum = 0.0;
+    for (unsigned int i = 0; i < count; i++)
+        sum += sorted[i];
+
+    stats.min = sorted[0];
+    stats.mean = (float)(sum / count);
+    stats.p99 = sorted[(count * 99 - 1) / 100];
+    stats.last = values[(next + profileWindow - 1) % profileWindow];
+    stats.samples = count;
+    return stats;
+}
@@ -0,0 +1,162 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// if we want to measure phases of the step
+#define RIGIDBODY_PROFILE
+// if we want profiling compiled out - comment out the line above
+
+
+// measured parts of World::Step
+enum ProfilePhase
+{
+    PhaseStep,
+    PhaseCommands,
+    PhaseBroadphase,
+    PhasePairs,
+    PhaseNarrowphase,
+    PhaseSensors,
+    PhasePrepareContacts,
+    PhaseIntegrateForces,
+    PhaseSolve,
+    PhaseContactEvents,
+    PhaseIntegrateVelocities,
+    PhaseCorrectPositions,
+    PhaseClearForces,
+    PhaseCount
+};
+
+
+// counted amounts of work of one step
+enum ProfileCounter
+{
+    CounterPairsTested,
+    CounterContactsGenerated,
+    CounterSolverIterations,
+    CounterBodiesIntegrated,
+    CounterCount
+};
+
+
+// statistics of the last steps
+struct ProfileStats
+{
+    float min = 0.0f;
+    float mean = 0.0f;
+    float p99 = 0.0f;               // 99th percentile
+    float last = 0.0f;
+    unsigned int samples = 0;
+};
+
+
+// number of last steps kept by the profiler
+const unsigned int profileWindow = 256;
+
+
+// Profiler class - times of phases and counters of work of the last steps
+// every phase and counter is written by one job of the step, so recording needs no synchronization;
+// statistics are calculated only when they are queried, from the thread which steps the world
+class Profiler
+{
+public:
+    // constructor
+    Profiler();
+
+    // starts a new step; values not written during the step are 0
+    void BeginStep();
+
+    // adds the step to the rolling window; time from BeginStep is the time of PhaseStep
+    void EndStep();
+
+    // adds time to a phase of the current step; the time is also added to the trace if it is recorded
+    // phase - measured phase
+    // start - performance counter value at start of the phase
+    // end - performance counter value at end of the phase
+    void AddTime(ProfilePhase phase, long long start, long long end);
+
+    // sets a counter of the current step
+    // counter - target counter
+    // value - amount of work
+    void Count(ProfileCounter counter, unsigned int value);
+
+    // returns statistics of phase times in [ millisecond ]
+    // phase - measured phase
+    ProfileStats GetStats(ProfilePhase phase) const;
+
+    // returns statistics of a counter
+    // counter - target counter
+    ProfileStats GetStats(ProfileCounter counter) const;
+
+    // returns time of a phase in the last step in [ millisecond ] without calculating statistics
+    // phase - measured phase
+    float GetLast(ProfilePhase phase) const;
+
+    // returns number of steps in the window
+    unsigned int StepCount() const;
+
+    // drops all measured steps
+    void Reset();
+
+    // returns name of a phase
+    static const char* GetName(ProfilePhase phase);
+
+    // returns name of a counter
+    static const char* GetName(ProfileCounter counter);
+
+    // returns current performance counter value
+    static long long Now();
+
+private:
+    double millisecondsPerTick;
+
+    long long stepStart;
+    long long currentTimes[PhaseCount];
+    unsigned int currentCounters[CounterCount];
+
+    float times[PhaseCount][profileWindow];
+    float counters[CounterCount][profileWindow];
+    unsigned int next;
+    unsigned int count;
+
+    // calculates statistics of values in the window
+    ProfileStats Calculate(const float* values) const;
+};
+
+
+// ProfileScope class - adds time between its construction and destruction to a phase
+class ProfileScope
+{
+public:
+    ProfileScope(Profiler& _profiler, ProfilePhase _phase)
+        : profiler(_profiler), phase(_phase), start(Profiler::Now())
+    {
+    }
+
+    ~ProfileScope()
+    {
+        profiler.AddTime(phase, start, Profiler::Now());
+    }
+
+private:
+    Profiler& profiler;
+    ProfilePhase phase;
+    long long start;
+};
+
+
+#if defined(RIGIDBODY_PROFILE)
+    #define PROFILE_SCOPE(profiler, phase) ProfileScope profileScope((profiler), (phase))
+    #define PROFILE_COUNT(profiler, counter, value) (profiler).Count((counter), (unsigned int)(value))
+    #define PROFILE_BEGIN_STEP(profiler) (profiler).BeginStep()
+    #define PROFILE_END_STEP(profiler) (profiler).EndStep()
+#else
+    #define PROFILE_SCOPE(profiler, phase) ((void)0)
+    #define PROFILE_COUNT(profiler, counter, value) ((void)0)
+    #define PROFILE_BEGIN_STEP(profiler) ((void)0)
+    #define PROFILE_END_STEP(profiler) ((void)0)
+#endif
+
+#endif // PROFILER_H
@@ -0,0 +1,308 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#include "IncludesManager.h"
+
+// number of triangles sorted into tiles by one job
+const unsigned int triangleGrain = 2048;
+
+
+// returns twice the signed area of triangle a, b, p; positive when p is on the left of a -> b
+static float Orient(float ax, float ay, float bx, float by, float px, float py)
+{
+    return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+}
+
+// returns color component as a byte
+static uint8_t ToByte(float value)
+{
+    return (uint8_t)(std::min(1.0f, std::max(0.0f, value)) * 255.0f + 0.5f);
+}
+
+
+Rasterizer::Rasterizer(unsigned int _width, unsigned int _height)
+{
+    width = _width;
+    height = _height;
+    tilesX = (width + rasterTileSize - 1) / rasterTileSize;
+    tilesY = (height + rasterTileSize - 1) / rasterTileSize;
+    pixels.resize((size_t)width * height * 4);
+    background.red = 0.0f;
+    background.green = 0.0f;
+    background.blue = 0.0f;
+}
+
+void Rasterizer::Draw(const World& world, const AABB& view, JobSystem& jobs)
+{
+    batch.Build(world, view, width / (view.max.x - view.min.x), jobs);
+    Draw(batch, view, jobs);
+}
+
+void Rasterizer::Draw(const RenderBatch& source, const AABB& view, JobSystem& jobs)
+{
+    const std::vector<RenderVertex>& vertices = source.GetVertices();
+    unsigned int count = (unsigned int)vertices.size() / 3;
+    unsigned int chunks = (count + triangleGrain - 1) / triangleGrain;
+    float scaleX = width / (view.max.x - view.min.x);
+    float scaleY = height / (view.max.y - view.min.y);
+
+    triangles.resize(count);
+    if (bins.size() < chunks)
+        bins.resize(chunks);
+
+    // binning - every chunk of triangles is sorted into its own lists, so no list is shared by threads
+    jobs.ParallelFor(count, triangleGrain, [&](unsigned int begin, unsigned int end)
+    {
+        std::vector<std::vector<unsigned int>>& chunk = bins[begin / triangleGrain];
+        chunk.resize(tilesX * tilesY);
+        for (unsigned int t = 0; t < chunk.size(); t++)
+            chunk[t].clear();
+
+        for (unsigned int i = begin; i < end; i++)
+        {
+            ScreenTriangle& triangle = triangles[i];
+            for (int c = 0; c < 3; c++)
+            {
+                triangle.x[c] = (vertices[3 * i + c].x - view.min.x) * scaleX;
+                triangle.y[c] = (vertices[3 * i + c].y - view.min.y) * scaleY;
+            }
+
+            // with the y axis pointing down counterclockwise means negative area
+            float area = Orient(triangle.x[0], triangle.y[0], triangle.x[1], triangle.y[1], triangle.x[2], triangle.y[2]);
+            if (area == 0.0f)
+                continue;
+            if (area > 0.0f)
+            {
+                std::swap(triangle.x[1], triangle.x[2]);
+                std::swap(triangle.y[1], triangle.y[2]);
+            }
+
+            // pixels whose centers may be inside
+            float minX = std::min(triangle.x[0], std::min(triangle.x[1], triangle.x[2]));
+            float maxX = std::max(triangle.x[0], std::max(triangle.x[1], triangle.x[2]));
+            float minY = std::min(triangle.y[0], std::min(triangle.y[1], triangle.y[2]));
+            float maxY = std::max(triangle.y[0], std::max(triangle.y[1], triangle.y[2]));
+            triangle.minX = std::max(0, (int)std::ceil(minX - 0.5f));
+            triangle.minY = std::max(0, (int)std::ceil(minY - 0.5f));
+            triangle.maxX = std::min((int)width - 1, (int)std::floor(maxX - 0.5f));
+            triangle.maxY = std::min((int)height - 1, (int)std::floor(maxY - 0.5f));
+            if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+                continue;
+
+            triangle.color[0] = ToByte(vertices[3 * i].red);
+            triangle.color[1] = ToByte(vertices[3 * i].green);
+            triangle.color[2] = ToByte(vertices[3 * i].blue);
+            triangle.color[3] = 255;
+
+            for (int ty = triangle.minY / (int)rasterTileSize; ty <= triangle.maxY / (int)rasterTileSize; ty++)
+                for (int tx = triangle.minX / (int)rasterTileSize; tx <= triangle.maxX / (int)rasterTileSize; tx++)
+                    chunk[ty * tilesX + tx].push_back(i);
+        }
+    });
+
+    uint8_t clear[4] = { ToByte(background.red), ToByte(background.green), ToByte(background.blue), 255 };
+
+    // filling - every tile is cleared and then covered by its triangles in order of the batch
+    jobs.ParallelFor(tilesX * tilesY, 1, [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int tile = begin; tile < end; tile++)
+        {
+            int left = (tile % tilesX) * rasterTileSize;
+            int top = (tile / tilesX) * rasterTileSize;
+            int right = std::min(left + (int)rasterTileSize, (int)width) - 1;
+            int bottom = std::min(top + (int)rasterTileSize, (int)height) - 1;
+
+            for (int y = top; y <= bottom; y++)
+            {
+                uint8_t* row = &pixels[((size_t)y * width + left) * 4];
+                for (int x = left; x <= right; x++, row += 4)
+                    memcpy(row, clear, 4);
+            }
+
+            for (unsigned int chunk = 0; chunk < chunks; chunk++)
+            {
+                const std::vector<unsigned int>& list = bins[chunk][tile];
+                for (unsigned int i = 0; i < list.size(); i++)
+                    Fill(triangles[list[i]], left, top, right, bottom);
+            }
+        }
+    });
+}
+
+void Rasterizer::Fill(const ScreenTriangle& triangle, int left, int top, int right, int bottom)
+{
+    int minX = std::max(triangle.minX, left);
+    int maxX = std::min(triangle.maxX, right);
+    int minY = std::max(triangle.minY, top);
+    int maxY = std::min(triangle.maxY, bottom);
+    if (minX > maxX || minY > maxY)
+        return;
+
+    const float* x = triangle.x;
+    const float* y = triangle.y;
+
+    // edge functions at the center of the first pixel and their changes for one pixel to the right and down
+    float px = minX + 0.5f;
+    float py = minY + 0.5f;
+    float row0 = Orient(x[1], y[1], x[2], y[2], px, py);
+    float row1 = Orient(x[2], y[2], x[0], y[0], px, py);
+    float row2 = Orient(x[0], y[0], x[1], y[1], px, py);
+    float stepX0 = y[1] - y[2], stepY0 = x[2] - x[1];
+    float stepX1 = y[2] - y[0], stepY1 = x[0] - x[2];
+    float stepX2 = y[0] - y[1], stepY2 = x[1] - x[0];
+
+    for (int row = minY; row <= maxY; row++)
+    {
+        float w0 = row0, w1 = row1, w2 = row2;
+        uint8_t* out = &pixels[((size_t)row * width + minX) * 4];
+        for (int column = minX; column <= maxX; column++, out += 4)
+        {
+            if (w0 <= 0.0f && w1 <= 0.0f && w2 <= 0.0f)
+                memcpy(out, triangle.color, 4);
+            w0 += stepX0;
+            w1 += stepX1;
+            w2 += stepX2;
+        }
+        row0 += stepY0;
+        row1 += stepY1;
+        row2 += stepY2;
+    }
+}
+
+const std::vector<uint8_t>& Rasterizer::GetPixels() const
+{
+    return pixels;
+}
+
+unsigned int Rasterizer::GetWidth() const
+{
+    return width;
+}
+
+unsigned int Rasterizer::GetHeight() const
+{
+    return height;
+}
+
+bool Rasterizer::WriteRaw(FILE* file) const
+{
+    return fwrite(pixels.data(), 1, pixels.size(), file) == pixels.size();
+}
+
+
+// CRC-32 of every byte value, as used by PNG chunks
+struct CrcTable
+{
+    uint32_t values[256];
+
+    CrcTable()
+    {
+        for (uint32_t n = 0; n < 256; n++)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            values[n] = c;
+        }
+    }
+};
+
+// returns CRC-32 of bytes continuing from given crc
+static uint32_t Crc32(uint32_t crc, const uint8_t* data, size_t size)
+{
+    static const CrcTable table;
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+        crc = table.values[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// appends 32 bit number with the most significant byte first
+static void PutBigEndian(std::vector<uint8_t>& out, uint32_t value)
+{
+    out.push_back((uint8_t)(value >> 24));
+    out.push_back((uint8_t)(value >> 16));
+    out.push_back((uint8_t)(value >> 8));
+    out.push_back((uint8_t)value);
+}
+
+// appends PNG chunk with its length and CRC
+static void PutChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size)
+{
+    PutBigEndian(out, (uint32_t)size);
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data, data + size);
+    PutBigEndian(out, Crc32(0, &out[start], out.size() - start));
+}
+
+bool Rasterizer::SavePNG(const char* path) const
+{
+    // rows with filter type 0 ( none ) in front of every row
+    size_t rowBytes = (size_t)width * 4;
+    std::vector<uint8_t> raw;
+    raw.reserve((rowBytes + 1) * height);
+    for (unsigned int y = 0; y < height; y++)
+    {
+        raw.push_back(0);
+        raw.insert(raw.end(), pixels.begin() + y * rowBytes, pixels.begin() + (y + 1) * rowBytes);
+    }
+
+    // zlib stream of stored deflate blocks; frames are written for speed, not for size
+    std::vector<uint8_t> zlib;
+    zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+    size_t offset = 0;
+    do
+    {
+        size_t size = std::min<size_t>(65535, raw.size() - offset);
+        bool last = offset + size == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back((uint8_t)size);
+        zlib.push_back((uint8_t)(size >> 8));
+        zlib.push_back((uint8_t)~size);
+        zlib.push_back((uint8_t)(~size >> 8));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + size);
+        offset += size;
+    } while (offset < raw.size());
+
+    // Adler-32; 5552 bytes is the longest run which can't overflow before taking the modulo
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < raw.size(); )
+    {
+        size_t end = std::min<size_t>(raw.size(), i + 5552);
+        for (; i < end; i++)
+        {
+            a += raw[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    PutBigEndian(zlib, (b << 16) | a);
+
+    uint8_t header[13];
+    std::vector<uint8_t> size;
+    PutBigEndian(size, width);
+    PutBigEndian(size, height);
+    memcpy(header, size.data(), 8);
+    header[8] = 8;      // bits per channel
+    header[9] = 6;      // RGBA
+    header[10] = 0;     // deflate
+    header[11] = 0;     // adaptive filtering
+    header[12] = 0;     // no interlace
+
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::vector<uint8_t> out(signature, signature + 8);
+    PutChunk(out, "IHDR", header, sizeof(header));
+    PutChunk(out, "IDAT", zlib.data(), zlib.size());
+    PutChunk(out, "IEND", nullptr, 0);
+
+    FILE* file;
+    if (fopen_s(&file, path, "wb") != 0)
+        return false;
+    bool written = fwrite(out.data(), 1, out.size(), file) == out.size();
+    return fclose(file) == 0 && written;
+}
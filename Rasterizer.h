@@ -0,0 +1,83 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#ifndef RASTERIZER_H
+#define RASTERIZER_H
+
+#include <cstdint>
+#include <cstdio>
+
+class World;
+
+// size of the square tile filled by one job in [ pixel ]
+const unsigned int rasterTileSize = 64;
+
+
+// Rasterizer class - draws triangles of a render batch into an RGBA framebuffer on the processor
+// triangles are first sorted into tiles of the screen, then every tile is filled by one job,
+// so threads never write the same pixels; inside a tile triangles are drawn in order of the batch,
+// which gives the same picture as OpenGL drawing the batch
+class Rasterizer
+{
+public:
+    // constructor
+    // _width, _height - size of the framebuffer in [ pixel ]
+    Rasterizer(unsigned int _width, unsigned int _height);
+
+    // draws a batch over a cleared framebuffer
+    // batch - triangles to draw
+    // view - part of the world which fills the framebuffer; min is the top left corner like in gluOrtho2D(0, 80, 60, 0)
+    // jobs - job system which fills tiles in parallel
+    void Draw(const RenderBatch& batch, const AABB& view, JobSystem& jobs = JobSystem::Serial());
+
+    // draws bodies of a world which are in the view
+    // world - drawn world
+    // view - part of the world which fills the framebuffer
+    // jobs - job system which builds the batch and fills tiles in parallel
+    void Draw(const World& world, const AABB& view, JobSystem& jobs = JobSystem::Serial());
+
+    // returns pixels as bytes red, green, blue, alpha, row by row from the top
+    const std::vector<uint8_t>& GetPixels() const;
+
+    unsigned int GetWidth() const;
+    unsigned int GetHeight() const;
+
+    // writes the framebuffer as PNG file; returns false if the file can't be written
+    // path - path of the file
+    bool SavePNG(const char* path) const;
+
+    // appends the framebuffer as raw RGBA bytes, e.g. to a pipe of a video encoder; returns false if writing failed
+    // file - opened binary file
+    bool WriteRaw(FILE* file) const;
+
+    // background color
+    Color background;
+
+private:
+    // triangle in coordinates of the screen
+    struct ScreenTriangle
+    {
+        float x[3], y[3];           // counterclockwise on the screen
+        int minX, minY, maxX, maxY; // covered pixels
+        uint8_t color[4];
+    };
+
+    unsigned int width;
+    unsigned int height;
+    unsigned int tilesX;
+    unsigned int tilesY;
+    std::vector<uint8_t> pixels;
+
+    std::vector<ScreenTriangle> triangles;
+
+    // indices of triangles which cover every tile, separately for every chunk of the batch
+    std::vector<std::vector<std::vector<unsigned int>>> bins;
+
+    RenderBatch batch;
+
+    // fills pixels of a tile covered by a triangle
+    void Fill(const ScreenTriangle& triangle, int left, int top, int right, int bottom);
+};
+
+#endif // RASTERIZER_H
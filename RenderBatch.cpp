@@ -0,0 +1,199 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#include "IncludesManager.h"
+
+// number of bodies filled by one job
+const unsigned int renderGrain = 256;
+
+// numbers of segments of drawn circles; the finest level is used for everything larger
+static const unsigned int circleLevels[] = { 8, 12, 16, 24, 32, 48, 64 };
+static const unsigned int circleLevelCount = sizeof(circleLevels) / sizeof(circleLevels[0]);
+
+// the largest distance in pixels between a drawn circle and its segments
+const float circleTolerance = 0.5f;
+
+
+// points of unit circles of every level of detail
+struct UnitCircles
+{
+    std::vector<Vector2D> points[circleLevelCount];
+
+    UnitCircles()
+    {
+        for (unsigned int level = 0; level < circleLevelCount; level++)
+            for (unsigned int i = 0; i < circleLevels[level]; i++)
+            {
+                float angle = 2.0f * PI * i / circleLevels[level];
+                points[level].push_back(Vector2D(std::cos(angle), std::sin(angle)));
+            }
+    }
+};
+
+static const UnitCircles& GetUnitCircles()
+{
+    static UnitCircles circles;
+    return circles;
+}
+
+// returns index of the level with given number of segments
+static unsigned int GetLevel(unsigned int segments)
+{
+    unsigned int level = 0;
+    while (circleLevels[level] != segments)
+        level++;
+    return level;
+}
+
+// returns number of triangles of a body; circles, capsules and polygons are fans of their outlines, chains are quads of segments
+static unsigned int TriangleCount(const BodyState& body, float pixelsPerUnit)
+{
+    if (body.shape->GetType() == Shape::CircleID)
+        return RenderBatch::CircleSegments(((const Circle*)body.shape)->radius, pixelsPerUnit) - 2;
+    if (body.shape->GetType() == Shape::CapsuleID)
+        return RenderBatch::CircleSegments(((const Capsule*)body.shape)->radius, pixelsPerUnit);
+    if (body.shape->GetType() == Shape::ChainID)
+        return 2 * ((const Chain*)body.shape)->SegmentCount();
+    return ((const Poly*)body.shape)->verticesCount - 2;
+}
+
+
+unsigned int RenderBatch::CircleSegments(float radius, float pixelsPerUnit)
+{
+    // a segment of n-gon is at most r * ( 1 - cos( PI / n ) ) ~ r * PI^2 / ( 2 * n^2 ) from the circle
+    float pixels = radius * pixelsPerUnit;
+    float needed = PI * std::sqrt(std::max(pixels, 0.0f) / (2.0f * circleTolerance));
+    for (unsigned int level = 0; level < circleLevelCount; level++)
+        if (circleLevels[level] >= needed)
+            return circleLevels[level];
+    return circleLevels[circleLevelCount - 1];
+}
+
+void RenderBatch::Build(const std::vector<BodyState>& bodies, float pixelsPerUnit, JobSystem& jobs)
+{
+    // positions of bodies in the buffer are known before filling
+    unsigned int count = (unsigned int)bodies.size();
+    offsets.resize(count + 1);
+    offsets[0] = 0;
+    for (unsigned int i = 0; i < count; i++)
+        offsets[i + 1] = offsets[i] + 3 * TriangleCount(bodies[i], pixelsPerUnit);
+    vertices.resize(offsets[count]);
+
+    const UnitCircles& circles = GetUnitCircles();
+    jobs.ParallelFor(count, renderGrain, [&](unsigned int begin, unsigned int end)
+    {
+        Vector2D outline[MaxPolyVertexCount];
+        for (unsigned int i = begin; i < end; i++)
+        {
+            const BodyState& body = bodies[i];
+            unsigned int points = (offsets[i + 1] - offsets[i]) / 3 + 2;
+            Matrix2X2 rotation(body.orientation);
+
+            RenderVertex vertex;
+            vertex.red = body.color.red;
+            vertex.green = body.color.green;
+            vertex.blue = body.color.blue;
+            RenderVertex* out = &vertices[offsets[i]];
+
+            if (body.shape->GetType() == Shape::ChainID)
+            {
+                // every segment is a quad as wide as chainLineWidth pixels
+                const Chain* chain = (const Chain*)body.shape;
+                float halfWidth = 0.5f * chainLineWidth / pixelsPerUnit;
+                int segments = chain->SegmentCount();
+                for (int s = 0; s < segments; s++)
+                {
+                    Vector2D a = body.position + rotation * chain->vertices[s];
+                    Vector2D b = body.position + rotation * chain->vertices[(s + 1) % chain->vertices.size()];
+                    Vector2D side = rotation * chain->normals[s] * halfWidth;
+                    Vector2D corners[6] = { a - side, b - side, b + side, a - side, b + side, a + side };
+                    for (int c = 0; c < 6; c++)
+                    {
+                        vertex.x = corners[c].x;
+                        vertex.y = corners[c].y;
+                        *out++ = vertex;
+                    }
+                }
+                continue;
+            }
+
+            if (body.shape->GetType() == Shape::CircleID)
+            {
+                const std::vector<Vector2D>& unit = circles.points[GetLevel(points)];
+                float radius = ((const Circle*)body.shape)->radius;
+                for (unsigned int p = 0; p < points; p++)
+                    outline[p] = body.position + rotation * unit[p] * radius;
+            }
+            else if (body.shape->GetType() == Shape::CapsuleID)
+            {
+                // each end is a half of the circle, so the outline has both points on the sides twice
+                unsigned int segments = points - 2;
+                const std::vector<Vector2D>& unit = circles.points[GetLevel(segments)];
+                const Capsule* capsule = (const Capsule*)body.shape;
+                for (unsigned int p = 0; p <= segments / 2; p++)
+                {
+                    const Vector2D& front = unit[(p + segments - segments / 4) % segments];
+                    const Vector2D& back = unit[(p + segments / 4) % segments];
+                    outline[p] = body.position + rotation * (Vector2D(capsule->halfLength, 0.0f) + front * capsule->radius);
+                    outline[segments / 2 + 1 + p] = body.position + rotation * (Vector2D(-capsule->halfLength, 0.0f) + back * capsule->radius);
+                }
+            }
+            else
+            {
+                const Poly* poly = (const Poly*)body.shape;
+                for (unsigned int p = 0; p < points; p++)
+                    outline[p] = body.position + rotation * poly->verticesArray[p];
+            }
+
+            for (unsigned int p = 1; p + 1 < points; p++)
+            {
+                const Vector2D* corners[3] = { &outline[0], &outline[p], &outline[p + 1] };
+                for (int c = 0; c < 3; c++)
+                {
+                    vertex.x = corners[c]->x;
+                    vertex.y = corners[c]->y;
+                    *out++ = vertex;
+                }
+            }
+        }
+    });
+}
+
+void RenderBatch::Build(const World& world, const AABB& view, float pixelsPerUnit, JobSystem& jobs)
+{
+    world.CollectVisible(view, visible);
+
+    states.resize(visible.size());
+    for (unsigned int i = 0; i < visible.size(); i++)
+    {
+        RigidBody* b = visible[i];
+        BodyState& state = states[i];
+        state.id = b->id;
+        state.position = b->position;
+        state.orientation = b->orientation;
+        state.color = b->bodyColor;
+        state.shape = b->shape;
+    }
+
+    Build(states, pixelsPerUnit, jobs);
+}
+
+void RenderBatch::Submit() const
+{
+    if (vertices.empty())
+        return;
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, sizeof(RenderVertex), &vertices[0].x);
+    glColorPointer(3, GL_FLOAT, sizeof(RenderVertex), &vertices[0].red);
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)vertices.size());
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+const std::vector<RenderVertex>& RenderBatch::GetVertices() const
+{
+    return vertices;
+}
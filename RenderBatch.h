@@ -0,0 +1,73 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#ifndef RENDERBATCH_H
+#define RENDERBATCH_H
+
+class World;
+
+// pixels in one unit of the world when the scene doesn't tell otherwise ( 800 pixels wide window showing 80 units )
+const float defaultPixelsPerUnit = 10.0f;
+
+
+// state of a body needed to draw it
+struct BodyState
+{
+    unsigned int id;
+    Vector2D position;
+    float orientation;
+    Color color;
+    const Shape* shape;
+};
+
+
+// one corner of a drawn triangle
+struct RenderVertex
+{
+    float x, y;
+    float red, green, blue;
+};
+
+
+// RenderBatch class - turns bodies into one list of colored triangles, which is drawn with a single call
+// every body is a fan of triangles; circles take points from precomputed unit circles with
+// the number of segments chosen by their size on the screen, chains are quads of their segments
+// building doesn't use OpenGL, so it can be checked without a window
+class RenderBatch
+{
+public:
+    // fills the batch with given bodies
+    // bodies - states of drawn bodies
+    // pixelsPerUnit - scale of the view, which chooses level of detail of circles
+    // jobs - job system which fills parts of the batch in parallel
+    void Build(const std::vector<BodyState>& bodies, float pixelsPerUnit, JobSystem& jobs = JobSystem::Serial());
+
+    // fills the batch with bodies of a world which are in the view
+    // world - drawn world
+    // view - visible part of the world
+    // pixelsPerUnit - scale of the view, which chooses level of detail of circles
+    // jobs - job system which fills parts of the batch in parallel
+    void Build(const World& world, const AABB& view, float pixelsPerUnit, JobSystem& jobs = JobSystem::Serial());
+
+    // draws the batch with the current OpenGL matrices
+    void Submit() const;
+
+    // returns corners of triangles, three per triangle
+    const std::vector<RenderVertex>& GetVertices() const;
+
+    // returns number of segments of a drawn circle
+    // radius - radius of the circle
+    // pixelsPerUnit - scale of the view
+    static unsigned int CircleSegments(float radius, float pixelsPerUnit);
+
+private:
+    std::vector<RenderVertex> vertices;
+    std::vector<unsigned int> offsets;      // first vertex of every body
+
+    // bodies of the world drawn by the last build
+    std::vector<RigidBody*> visible;
+    std::vector<BodyState> states;
+};
+
+#endif // RENDERBATCH_H
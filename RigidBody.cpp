@@ -33,11 +33,30 @@ RigidBody::RigidBody(Shape* _shape, float x, float y, float _orientation, float
 
     torque = 0.0;
     orientation = _orientation;
+    shape->SetOrientation(_orientation);
     force.x = 0;
     force.y = 0;
     staticFriction = 0.4;
     kinetcFriction = 0.3;
     restitution = 1.0;
+
+    isSensor = false;
+    id = 0;
+    proxy = -1;
+}
+
+RigidBody::RigidBody(Shape* _shape)
+{
+    shape = _shape;
+    shape->body = this;
+    isSensor = false;
+    id = 0;
+    proxy = -1;
+}
+
+RigidBody::~RigidBody()
+{
+    delete shape;
 }
 
 void RigidBody::ApplyForce(const Vector2D& _force)
@@ -94,3 +113,8 @@ void RigidBody::SetColor(float r, float g, float b)
     bodyColor.green = g;
     bodyColor.blue = b;
 }
+
+void RigidBody::SetFilter(const CollisionFilter& _filter)
+{
+    filter = _filter;
+}
@@ -5,6 +5,8 @@
 #ifndef RIGIDBODY_H
 #define RIGIDBODY_H
 
+#include <cstdint>
+
 // declaration of Shape class
 class Shape;
 
@@ -19,6 +21,46 @@ struct Color
 };
 
 
+// decides which bodies can collide
+// two bodies with the same nonzero group always collide if it is positive and never if it is negative,
+// otherwise they collide when the category of each of them is in the mask of the other one
+// default - one category colliding with everything
+struct CollisionFilter
+{
+    uint16_t category = 0x0001;     // bit of the body
+    uint16_t mask = 0xFFFF;         // bits of bodies it collides with
+    int16_t group = 0;              // e.g. the same negative value for a projectile and its owner
+};
+
+// returns whether bodies with given filters can collide
+inline bool ShouldCollide(const CollisionFilter& a, const CollisionFilter& b)
+{
+    if (a.group == b.group && a.group != 0)
+        return a.group > 0;
+    return (a.category & b.mask) != 0 && (b.category & a.mask) != 0;
+}
+
+
+// initial state and material of a creating body
+struct BodyDefinition
+{
+    Vector2D position = Vector2D(0.0f, 0.0f);       // in [ meter ]
+    float orientation = 0.0f;                       // in [ radian ]
+    Vector2D velocity = Vector2D(0.0f, 0.0f);       // in [ meter / second ]
+    float angularVelocity = 0.0f;                   // in [ radian / second ]
+
+    float staticFriction = 0.4f;                    // dimensionless
+    float kineticFriction = 0.3f;                   // dimensionless
+    float restitution = 1.0f;                       // dimensionless
+    float density = 1.0f;                           // in [ kilogram / meter^2 ]
+    bool isStatic = false;
+    bool isSensor = false;                          // only reports overlaps, see RigidBody::isSensor
+
+    Color color;
+    CollisionFilter filter;
+};
+
+
 // Rigid Body class
 class RigidBody
 {
@@ -43,8 +85,16 @@ public:
 
     Shape* shape;
     Color bodyColor;
+    CollisionFilter filter;
+
+    // sensor only reports overlaps with other bodies in World::sensorBegins and World::sensorEnds;
+    // its pairs skip the narrowphase and the solver, so it never pushes bodies which enter it
+    bool isSensor;
 
-    // constructor
+    unsigned int id;                // unique in the world, increasing in order of adding
+    int proxy;                      // index of leaf in the broadphase tree
+
+    // constructor v1
     // _shape - pointer to target body shape
     // ( x, y ) - position of body center
     // _orientation - value of orientation angle to set
@@ -56,6 +106,13 @@ public:
     // we have to choose a type of body initialization in RigidBody.cpp in line 7-10
     RigidBody(Shape* _shape, float x, float y, float _orientation, float _mass, float _inertialMoment, float _density);
 
+    // constructor v2 - body which takes over the shape instead of copying it; state and mass properties are set by the caller
+    // _shape - pointer to shape which becomes owned by the body
+    RigidBody(Shape* _shape);
+
+    // destructor - releases own copy of the shape
+    ~RigidBody();
+
     // applies additonal force to the body
     // _force - pointer to Vector with additional force to apply
     void ApplyForce(const Vector2D& _force);
@@ -90,6 +147,10 @@ public:
     // sets body color
     // ( r, g, b ) values of color proportions in RGB model
     void SetColor(float r, float g, float b);
+
+    // sets which bodies it collides with; takes effect in the next step
+    // _filter - category, mask and group of the body
+    void SetFilter(const CollisionFilter& _filter);
 };
 
 #endif // RIGIDBODY_H
\ No newline at end of file
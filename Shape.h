@@ -18,7 +18,9 @@ public:
     {
         CircleID,   // 0
         PolygonID,  // 1
-        CountID,    // 2
+        ChainID,    // 2
+        CapsuleID,  // 3
+        CountID,    // 4
     };
 
     RigidBody* body;   
@@ -26,6 +28,9 @@ public:
     // constructor
     Shape() {}
 
+    // destructor
+    virtual ~Shape() {}
+
     // virtual method to create the indetic shape
     virtual Shape* Copy() const = 0;
 
@@ -37,9 +42,28 @@ public:
     // radians - rotation angle value to set
     virtual void SetOrientation(float radians) = 0;
 
+    // virtual method to calculate the smallest axis aligned box containing shape of the body
+    virtual AABB GetAABB() const = 0;
+
+    // virtual method to find where segment start + t * delta, t in [ 0, maxFraction ], enters the shape
+    // a segment which starts inside the shape doesn't hit it
+    // fraction - set to t of the entry point
+    // normal - set to normal vector of the surface at the entry point
+    virtual bool RayCast(const Vector2D& start, const Vector2D& delta, float maxFraction, float& fraction, Vector2D& normal) const = 0;
+
+    // virtual method to check whether point is inside the shape
+    // point - point in coordinates of the world
+    virtual bool Contains(const Vector2D& point) const = 0;
+
     // virtual method to draw shape
     virtual void Draw() const = 0;
 
+    // virtual method to draw shape in given place without reading body state
+    // position - position of shape center
+    // radians - orientation angle of shape
+    // color - color of shape
+    virtual void DrawAt(const Vector2D& position, float radians, const Color& color) const = 0;
+
     // virtual method to get shape indentyficator
     virtual int GetType() const = 0; 
 };
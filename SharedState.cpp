@@ -0,0 +1,278 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#include "IncludesManager.h"
+
+static_assert(sizeof(SharedStateHeader) == 64, "shared state header layout changed");
+static_assert(sizeof(SharedSlotHeader) == 16, "shared slot header layout changed");
+static_assert(sizeof(SharedBody) == 56, "shared body layout changed");
+
+// how many times a reader copies the newest slot before it assumes that the writer died during writing
+const unsigned int sharedReadAttempts = 1000;
+
+
+// returns size of one slot in bytes
+static size_t SlotBytes(uint32_t bodyCapacity)
+{
+    return sizeof(SharedSlotHeader) + (size_t)bodyCapacity * sizeof(SharedBody);
+}
+
+// returns size of the whole memory in bytes
+static size_t TotalBytes(uint32_t bodyCapacity, uint32_t vertexCapacity)
+{
+    return sizeof(SharedStateHeader) + sharedStateSlots * SlotBytes(bodyCapacity) + (size_t)vertexCapacity * 2 * sizeof(float);
+}
+
+// returns header of a slot
+static SharedSlotHeader* GetSlot(const char* view, uint32_t bodyCapacity, uint32_t slot)
+{
+    return (SharedSlotHeader*)(view + sizeof(SharedStateHeader) + slot * SlotBytes(bodyCapacity));
+}
+
+// returns pool of vertices
+static float* GetPool(const char* view, uint32_t bodyCapacity)
+{
+    return (float*)(view + sizeof(SharedStateHeader) + sharedStateSlots * SlotBytes(bodyCapacity));
+}
+
+
+SharedStateExport::SharedStateExport()
+{
+    mapping = NULL;
+    view = nullptr;
+    header = nullptr;
+}
+
+SharedStateExport::~SharedStateExport()
+{
+    Close();
+}
+
+bool SharedStateExport::Open(const char* name, unsigned int bodyCapacity, unsigned int vertexCapacity, float dt)
+{
+    Close();
+
+    size_t bytes = TotalBytes(bodyCapacity, vertexCapacity);
+    mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)((uint64_t)bytes >> 32), (DWORD)bytes, name);
+
+    // a mapping of the same name belongs to another exporter or is still held by a viewer;
+    // it may be smaller than this one and its readers would see it cleared, so it isn't reused
+    if (mapping && GetLastError() == ERROR_ALREADY_EXISTS)
+    {
+        Close();
+        return false;
+    }
+
+    view = mapping ? (char*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes) : nullptr;
+    if (!view)
+    {
+        Close();
+        return false;
+    }
+
+    // the magic is written last, so a reader never accepts a half initialized header
+    memset(view, 0, bytes);
+    header = (SharedStateHeader*)view;
+    header->version = sharedStateVersion;
+    header->byteOrder = worldFileByteOrder;
+    header->bodyCapacity = bodyCapacity;
+    header->vertexCapacity = vertexCapacity;
+    header->dt = dt;
+    header->latest.store(sharedStateSlots, std::memory_order_relaxed);
+    header->vertexCount.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(header->magic, sharedStateMagic, sizeof(header->magic));
+
+    vertices.clear();
+    return true;
+}
+
+void SharedStateExport::Close()
+{
+    if (view)
+        UnmapViewOfFile(view);
+    if (mapping)
+        CloseHandle(mapping);
+    mapping = NULL;
+    view = nullptr;
+    header = nullptr;
+}
+
+void SharedStateExport::Publish(const World& world)
+{
+    if (!header)
+        return;
+
+    uint32_t latest = header->latest.load(std::memory_order_relaxed);
+    uint32_t slotIndex = latest >= sharedStateSlots ? 0 : (latest + 1) % sharedStateSlots;
+    SharedSlotHeader* slot = GetSlot(view, header->bodyCapacity, slotIndex);
+    SharedBody* records = (SharedBody*)(slot + 1);
+    float* pool = GetPool(view, header->bodyCapacity);
+
+    uint32_t sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint32_t count = (uint32_t)std::min<size_t>(world.bodies.size(), header->bodyCapacity);
+    uint32_t used = header->vertexCount.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const RigidBody* body = world.bodies[i];
+        SharedBody& record = records[i];
+        record.id = body->id;
+        record.shapeType = body->shape->GetType();
+        record.position[0] = body->position.x;
+        record.position[1] = body->position.y;
+        record.orientation = body->orientation;
+        record.color[0] = body->bodyColor.red;
+        record.color[1] = body->bodyColor.green;
+        record.color[2] = body->bodyColor.blue;
+        record.radius = 0.0f;
+        record.halfLength = 0.0f;
+        record.firstVertex = sharedNoVertices;
+        record.vertexCount = 0;
+        record.isLoop = 0;
+        record.reserved = 0;
+
+        if (record.shapeType == Shape::CircleID)
+        {
+            record.radius = ((const Circle*)body->shape)->radius;
+            continue;
+        }
+        if (record.shapeType == Shape::CapsuleID)
+        {
+            record.radius = ((const Capsule*)body->shape)->radius;
+            record.halfLength = ((const Capsule*)body->shape)->halfLength;
+            continue;
+        }
+
+        const Vector2D* outline;
+        uint32_t outlineCount;
+        if (record.shapeType == Shape::ChainID)
+        {
+            const Chain* chain = (const Chain*)body->shape;
+            outline = chain->vertices.data();
+            outlineCount = (uint32_t)chain->vertices.size();
+            record.isLoop = chain->loop;
+        }
+        else
+        {
+            const Poly* poly = (const Poly*)body->shape;
+            outline = poly->verticesArray;
+            outlineCount = poly->verticesCount;
+        }
+        record.vertexCount = outlineCount;
+
+        auto found = vertices.find(body->id);
+        if (found == vertices.end())
+        {
+            uint32_t first = sharedNoVertices;
+            if (used + outlineCount <= header->vertexCapacity)
+            {
+                first = used;
+                for (uint32_t v = 0; v < outlineCount; v++)
+                {
+                    pool[2 * (used + v)] = outline[v].x;
+                    pool[2 * (used + v) + 1] = outline[v].y;
+                }
+                used += outlineCount;
+            }
+            found = vertices.insert(std::make_pair(body->id, first)).first;
+        }
+        record.firstVertex = found->second;
+    }
+    slot->bodyCount = count;
+    slot->step = world.stepIndex;
+
+    header->vertexCount.store(used, std::memory_order_relaxed);
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+    header->latest.store(slotIndex, std::memory_order_release);
+}
+
+
+SharedStateView::SharedStateView()
+{
+    mapping = NULL;
+    view = nullptr;
+    header = nullptr;
+}
+
+SharedStateView::~SharedStateView()
+{
+    Close();
+}
+
+bool SharedStateView::Open(const char* name)
+{
+    Close();
+
+    mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+    view = mapping ? (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view)
+    {
+        Close();
+        return false;
+    }
+
+    header = (const SharedStateHeader*)view;
+    bool valid = memcmp(header->magic, sharedStateMagic, sizeof(header->magic)) == 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!valid || header->version != sharedStateVersion || header->byteOrder != worldFileByteOrder)
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void SharedStateView::Close()
+{
+    if (view)
+        UnmapViewOfFile(view);
+    if (mapping)
+        CloseHandle(mapping);
+    mapping = NULL;
+    view = nullptr;
+    header = nullptr;
+}
+
+bool SharedStateView::Read(SharedFrame& frame) const
+{
+    if (!header)
+        return false;
+
+    for (unsigned int attempt = 0; attempt < sharedReadAttempts; attempt++)
+    {
+        uint32_t latest = header->latest.load(std::memory_order_acquire);
+        if (latest >= sharedStateSlots)
+            return false;
+
+        const SharedSlotHeader* slot = GetSlot(view, header->bodyCapacity, latest);
+        uint32_t sequence = slot->sequence.load(std::memory_order_acquire);
+        if (sequence & 1)
+            continue;
+
+        uint32_t count = std::min(slot->bodyCount, header->bodyCapacity);
+        frame.step = slot->step;
+        frame.bodies.resize(count);
+        memcpy(frame.bodies.data(), slot + 1, count * sizeof(SharedBody));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->sequence.load(std::memory_order_relaxed) == sequence)
+            return true;
+    }
+    return false;
+}
+
+const float* SharedStateView::GetVertices(const SharedBody& body) const
+{
+    if (!header || body.firstVertex == sharedNoVertices || body.firstVertex + body.vertexCount > header->vertexCapacity)
+        return nullptr;
+    return GetPool(view, header->bodyCapacity) + 2 * body.firstVertex;
+}
+
+float SharedStateView::GetDt() const
+{
+    return header ? header->dt : 0.0f;
+}
@@ -0,0 +1,150 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#ifndef SHAREDSTATE_H
+#define SHAREDSTATE_H
+
+#include <cstdint>
+#include <unordered_map>
+
+class World;
+
+// layout of the shared memory which another process maps to draw the world
+//
+//   SharedStateHeader
+//   SharedSlotHeader, SharedBody[bodyCapacity]       - slot 0
+//   SharedSlotHeader, SharedBody[bodyCapacity]       - slot 1
+//   SharedSlotHeader, SharedBody[bodyCapacity]       - slot 2
+//   float[2 * vertexCapacity]                        - vertices of polygons and chains
+//
+// every step is written to the slot after the newest one, so a reader of the newest slot has
+// a whole step before the writer comes back to it; a sequence number which is odd during writing
+// tells the reader whether its copy was torn, in which case it simply reads the newest slot again
+// vertices of a polygon or chain are appended once, when its body is published for the first time, and never change
+
+const char sharedStateMagic[8] = { 'R', 'B', '2', 'D', 'S', 'H', 'R', 'D' };
+const uint32_t sharedStateVersion = 4;
+const uint32_t sharedStateSlots = 3;
+
+// marks that vertices of a polygon didn't fit in the shared memory
+const uint32_t sharedNoVertices = UINT_MAX;
+
+
+struct SharedStateHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;                     // worldFileByteOrder of the writing machine
+    uint32_t bodyCapacity;                  // number of bodies which fit in one slot
+    uint32_t vertexCapacity;                // number of vertices which fit in the pool
+    float dt;                               // length of a step in [ second ]
+    std::atomic<uint32_t> latest;           // slot of the newest step; sharedStateSlots before the first one
+    std::atomic<uint32_t> vertexCount;      // number of used vertices of the pool
+    uint32_t reserved[7];
+};
+
+
+struct SharedSlotHeader
+{
+    std::atomic<uint32_t> sequence;         // odd while the slot is written
+    uint32_t bodyCount;
+    uint64_t step;                          // World::stepIndex after the step
+};
+
+
+// state of a body needed to draw it
+struct SharedBody
+{
+    uint32_t id;
+    uint32_t shapeType;                     // Shape::ID
+    float position[2];
+    float orientation;
+    float radius;                           // circles, capsules
+    uint32_t firstVertex;                   // polygons, chains - index in the pool or sharedNoVertices
+    uint32_t vertexCount;                   // polygons, chains
+    uint32_t isLoop;                        // chains - whether the last vertex is connected with the first one
+    float color[3];
+    float halfLength;                       // capsules
+    uint32_t reserved;
+};
+
+
+// one consistent step copied from the shared memory
+struct SharedFrame
+{
+    uint64_t step = 0;
+    std::vector<SharedBody> bodies;
+};
+
+
+// SharedStateExport class - publishes state of bodies after every step into named shared memory
+// publishing writes straight to the mapped memory and never waits for readers or calls the system
+class SharedStateExport
+{
+public:
+    // constructor
+    SharedStateExport();
+
+    // destructor - releases the memory
+    ~SharedStateExport();
+
+    // creates named shared memory; returns false if it can't be created or the name is already in use
+    // name - name of the memory which readers open
+    // bodyCapacity - number of bodies which can be published; further ones are skipped
+    // vertexCapacity - number of vertices of polygons which can be published during the whole session
+    // dt - length of a step in [ second ]
+    bool Open(const char* name, unsigned int bodyCapacity, unsigned int vertexCapacity, float dt);
+
+    // releases the memory
+    void Close();
+
+    // writes state of bodies; called by the world after every step
+    // world - stepped world
+    void Publish(const World& world);
+
+private:
+    HANDLE mapping;
+    char* view;
+    SharedStateHeader* header;
+
+    // first vertex of every polygon which was published
+    std::unordered_map<unsigned int, uint32_t> vertices;
+};
+
+
+// SharedStateView class - reads state of bodies published by another process
+class SharedStateView
+{
+public:
+    // constructor
+    SharedStateView();
+
+    // destructor - releases the memory
+    ~SharedStateView();
+
+    // maps named shared memory; returns false if it doesn't exist or is invalid
+    // name - name given to SharedStateExport::Open
+    bool Open(const char* name);
+
+    // releases the memory
+    void Close();
+
+    // copies the newest step; returns false if nothing was published yet
+    // frame - filled with the copied step
+    bool Read(SharedFrame& frame) const;
+
+    // returns vertices of a polygon as pairs of coordinates
+    // body - body of copied frame
+    const float* GetVertices(const SharedBody& body) const;
+
+    // returns length of a step in [ second ]
+    float GetDt() const;
+
+private:
+    HANDLE mapping;
+    const char* view;
+    const SharedStateHeader* header;
+};
+
+#endif // SHAREDSTATE_H
@@ -0,0 +1,197 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#include "IncludesManager.h"
+
+// the longest time which is simulated at once; protects from spiral of death after a long break
+const double maxFrameTime = 0.1;
+
+
+SimulationThread::SimulationThread(World& _world) : world(_world)
+{
+    running = false;
+    publishCount = 0;
+    renderHeld = ULLONG_MAX;
+    chart = nullptr;
+    view = AABB(Vector2D(-FLT_MAX, -FLT_MAX), Vector2D(FLT_MAX, FLT_MAX));
+}
+
+SimulationThread::~SimulationThread()
+{
+    Stop();
+    ReleaseRetired(ULLONG_MAX);
+}
+
+void SimulationThread::Start()
+{
+    if (running)
+        return;
+
+    startTime = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(worldMutex);
+        Publish(0.0);
+        Publish(0.0);
+    }
+
+    running = true;
+    thread = std::thread(&SimulationThread::Run, this);
+}
+
+void SimulationThread::Stop()
+{
+    running = false;
+    if (thread.joinable())
+        thread.join();
+}
+
+std::unique_lock<std::mutex> SimulationThread::LockWorld()
+{
+    return std::unique_lock<std::mutex>(worldMutex);
+}
+
+void SimulationThread::SetChart(PerformanceChart* _chart)
+{
+    chart = _chart;
+}
+
+void SimulationThread::SetView(const AABB& _view)
+{
+    std::lock_guard<std::mutex> lock(stateMutex);
+    view = _view;
+}
+
+void SimulationThread::Render(float pixelsPerUnit)
+{
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        renderHeld = publishCount;
+        renderPrevious.bodies.assign(previous.bodies.begin(), previous.bodies.end());
+        renderPrevious.time = previous.time;
+        renderCurrent.bodies.assign(current.bodies.begin(), current.bodies.end());
+        renderCurrent.time = current.time;
+    }
+
+    // the current state is shown one step late, so there are always two states to interpolate between
+    float alpha = 1.0f;
+    if (renderCurrent.time > renderPrevious.time)
+        alpha = (float)((Now() - renderCurrent.time) / (renderCurrent.time - renderPrevious.time));
+    alpha = std::min(1.0f, std::max(0.0f, alpha));
+
+    // both states are sorted by id, so bodies are matched by merging them
+    renderStates.assign(renderCurrent.bodies.begin(), renderCurrent.bodies.end());
+    unsigned int j = 0;
+    for (unsigned int i = 0; i < renderStates.size(); i++)
+    {
+        BodyState& state = renderStates[i];
+        while (j < renderPrevious.bodies.size() && renderPrevious.bodies[j].id < state.id)
+            j++;
+
+        if (j < renderPrevious.bodies.size() && renderPrevious.bodies[j].id == state.id)
+        {
+            const BodyState& old = renderPrevious.bodies[j];
+            state.position = old.position + (state.position - old.position) * alpha;
+            state.orientation = old.orientation + (state.orientation - old.orientation) * alpha;
+        }
+    }
+
+    batch.Build(renderStates, pixelsPerUnit);
+    batch.Submit();
+
+    std::lock_guard<std::mutex> lock(stateMutex);
+    renderHeld = ULLONG_MAX;
+}
+
+void SimulationThread::Run()
+{
+    double accumulator = 0.0;
+    double last = Now();
+
+    while (running)
+    {
+        double now = Now();
+        accumulator += now - last;
+        last = now;
+
+        if (accumulator > maxFrameTime)
+            accumulator = maxFrameTime;
+
+        float dt = world.settings.dt;
+        while (accumulator >= dt)
+        {
+            accumulator -= dt;
+
+            std::lock_guard<std::mutex> lock(worldMutex);
+            world.Step();
+            if (PerformanceChart* target = chart.load())
+                target->Push(world);
+            Retire();
+            Publish(now - accumulator);
+        }
+
+        // sleeps until the next step is due
+        std::this_thread::sleep_for(std::chrono::duration<double>(dt - accumulator));
+    }
+}
+
+void SimulationThread::Publish(double time)
+{
+    AABB published;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        published = view;
+    }
+
+    // the renderer gets only bodies which it can see, so copying scales with the view instead of the world
+    world.CollectVisible(published, visible);
+    back.bodies.resize(visible.size());
+    for (unsigned int i = 0; i < visible.size(); i++)
+    {
+        RigidBody* b = visible[i];
+        BodyState& state = back.bodies[i];
+        state.id = b->id;
+        state.position = b->position;
+        state.orientation = b->orientation;
+        state.color = b->bodyColor;
+        state.shape = b->shape;
+    }
+    back.time = time;
+
+    unsigned long long safeCount;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        std::swap(previous, current);
+        std::swap(current, back);
+        publishCount++;
+        safeCount = std::min(publishCount, renderHeld);
+    }
+    ReleaseRetired(safeCount);
+}
+
+void SimulationThread::Retire()
+{
+    // the next published state is the first one without these bodies
+    for (unsigned int i = 0; i < world.removedBodies.size(); i++)
+        retired.push_back(std::make_pair(world.removedBodies[i], publishCount + 1));
+    world.removedBodies.clear();
+}
+
+void SimulationThread::ReleaseRetired(unsigned long long safeCount)
+{
+    // states are kept in pairs, so a body disappears from all of them one publish later
+    unsigned int kept = 0;
+    for (unsigned int i = 0; i < retired.size(); i++)
+    {
+        if (retired[i].second < safeCount)
+            delete retired[i].first;
+        else
+            retired[kept++] = retired[i];
+    }
+    retired.resize(kept);
+}
+
+double SimulationThread::Now() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
@@ -0,0 +1,99 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#ifndef SIMULATIONTHREAD_H
+#define SIMULATIONTHREAD_H
+
+#include <chrono>
+
+class World;
+class Shape;
+class PerformanceChart;
+
+
+// state of the whole world after one step
+struct RenderState
+{
+    std::vector<BodyState> bodies;    // sorted by body id
+    double time = 0.0;                // moment of publishing in [ second ] since start of simulation
+};
+
+
+// SimulationThread class - steps a world with a fixed rate on its own thread
+// after every step the thread publishes body transforms; the two latest states are kept,
+// so the renderer can interpolate between them while the next step is computed
+class SimulationThread
+{
+public:
+    // constructor
+    // _world - world which is simulating; its settings.dt is the length of a step
+    SimulationThread(World& _world);
+
+    // destructor - stops simulation
+    ~SimulationThread();
+
+    // starts stepping the world
+    void Start();
+
+    // stops stepping the world and waits for the current step
+    void Stop();
+
+    // returns lock which excludes stepping, so the world can be safely changed from another thread
+    std::unique_lock<std::mutex> LockWorld();
+
+    // sets chart which receives statistics of every step; nullptr stops feeding it
+    // _chart - performance overlay drawn by the rendering thread
+    void SetChart(PerformanceChart* _chart);
+
+    // sets part of the world which is drawn; only bodies in it are published
+    // _view - visible part of the world
+    void SetView(const AABB& _view);
+
+    // draws the world interpolated between the two latest states; called from the rendering thread
+    // pixelsPerUnit - scale of the view, which chooses level of detail of circles
+    void Render(float pixelsPerUnit = defaultPixelsPerUnit);
+
+private:
+    World& world;
+    std::thread thread;
+    std::atomic<bool> running;
+    std::chrono::steady_clock::time_point startTime;
+    std::atomic<PerformanceChart*> chart;
+
+    std::mutex worldMutex;
+    std::mutex stateMutex;
+    AABB view;
+    std::vector<RigidBody*> visible;
+    RenderState previous;
+    RenderState current;
+    RenderState back;
+
+    RenderState renderPrevious;
+    RenderState renderCurrent;
+    std::vector<BodyState> renderStates;
+    RenderBatch batch;
+
+    // removed bodies may still be drawn from published states, so they are deleted
+    // once neither the published states nor the renderer's copies can contain them
+    unsigned long long publishCount;
+    unsigned long long renderHeld;
+    std::vector<std::pair<RigidBody*, unsigned long long>> retired;
+
+    // simulation thread loop
+    void Run();
+
+    // copies body transforms and replaces the older of published states; world has to be locked
+    void Publish(double time);
+
+    // takes over bodies removed during the last step
+    void Retire();
+
+    // deletes retired bodies which can't be drawn anymore
+    void ReleaseRetired(unsigned long long safeCount);
+
+    // returns time since start of simulation in [ second ]
+    double Now() const;
+};
+
+#endif // SIMULATIONTHREAD_H
@@ -0,0 +1,246 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#include "IncludesManager.h"
+
+// every changed body starts with one word: index of the body above the mask of changed words
+const unsigned int snapshotMaskBits = snapshotWords;
+const uint32_t snapshotMask = (1u << snapshotMaskBits) - 1;
+const unsigned int maxSnapshotBodies = 1u << (32 - snapshotMaskBits);
+
+
+// writes bits of dynamic state of the body
+static void Capture(const RigidBody* body, BodySnapshot& snapshot)
+{
+    float values[snapshotWords] = {
+        body->position.x, body->position.y,
+        body->velocity.x, body->velocity.y,
+        body->angularVelocity, body->orientation,
+        body->force.x, body->force.y,
+        body->torque
+    };
+    memcpy(snapshot.words, values, sizeof(values));
+    snapshot.words[9] = body->filter.category | (uint32_t)body->filter.mask << 16;
+    snapshot.words[10] = (uint16_t)body->filter.group | (uint32_t)body->isSensor << 16;
+}
+
+// sets dynamic state of the body from saved bits
+static void Apply(const BodySnapshot& snapshot, RigidBody* body)
+{
+    float values[9];
+    memcpy(values, snapshot.words, sizeof(values));
+
+    body->position = Vector2D(values[0], values[1]);
+    body->velocity = Vector2D(values[2], values[3]);
+    body->angularVelocity = values[4];
+    body->SetOrientation(values[5]);
+    body->force = Vector2D(values[6], values[7]);
+    body->torque = values[8];
+
+    CollisionFilter filter;
+    filter.category = (uint16_t)snapshot.words[9];
+    filter.mask = (uint16_t)(snapshot.words[9] >> 16);
+    filter.group = (int16_t)(uint16_t)snapshot.words[10];
+    body->SetFilter(filter);
+    body->isSensor = (snapshot.words[10] >> 16) != 0;
+}
+
+
+SnapshotBuffer::SnapshotBuffer(unsigned int _capacity)
+{
+    assert(_capacity > 0);
+    capacity = _capacity;
+    frames.resize(capacity);
+    nextFrame = 1;
+    Clear();
+}
+
+unsigned long long SnapshotBuffer::Save(const World& world)
+{
+    const std::vector<RigidBody*>& bodies = world.bodies;
+    assert(bodies.size() < maxSnapshotBodies);
+
+    // deltas can't describe added or removed bodies, so a new set of bodies starts the buffer again
+    bool sameBodies = count > 0 && ids.size() == bodies.size();
+    for (unsigned int i = 0; sameBodies && i < bodies.size(); i++)
+        sameBodies = bodies[i]->id == ids[i];
+
+    if (!sameBodies)
+    {
+        Clear();
+        ids.resize(bodies.size());
+        base.resize(bodies.size());
+        for (unsigned int i = 0; i < bodies.size(); i++)
+        {
+            ids[i] = bodies[i]->id;
+            Capture(bodies[i], base[i]);
+        }
+    }
+
+    newest = (newest + 1) % capacity;
+    if (count < capacity)
+        count++;
+
+    Frame& current = frames[newest];
+    current.number = nextFrame++;
+    current.stepIndex = world.stepIndex;
+    current.changedBodies = 0;
+    current.delta.clear();
+    current.touching = world.touching;
+    current.overlaps = world.overlaps;
+
+    if (!sameBodies)
+        return current.number;
+
+    BodySnapshot snapshot;
+    for (unsigned int i = 0; i < bodies.size(); i++)
+    {
+        Capture(bodies[i], snapshot);
+
+        uint32_t mask = 0;
+        for (unsigned int w = 0; w < snapshotWords; w++)
+        {
+            if (snapshot.words[w] != base[i].words[w])
+                mask |= 1u << w;
+        }
+        if (!mask)
+            continue;
+
+        current.changedBodies++;
+        current.delta.push_back(i << snapshotMaskBits | mask);
+        for (unsigned int w = 0; w < snapshotWords; w++)
+        {
+            if (mask & (1u << w))
+                current.delta.push_back(snapshot.words[w] ^ base[i].words[w]);
+        }
+        base[i] = snapshot;
+    }
+
+    return current.number;
+}
+
+bool SnapshotBuffer::Restore(World& world, unsigned long long frame)
+{
+    if (!Contains(frame) || world.bodies.size() != ids.size())
+        return false;
+
+    // undoing deltas from the newest frame touches only bodies which changed after the restored frame
+    isTouched.resize(base.size(), 0);
+    while (frames[newest].number > frame)
+    {
+        const std::vector<uint32_t>& delta = frames[newest].delta;
+        for (unsigned int k = 0; k < delta.size(); )
+        {
+            unsigned int index = delta[k] >> snapshotMaskBits;
+            uint32_t mask = delta[k] & snapshotMask;
+            k++;
+
+            for (unsigned int w = 0; w < snapshotWords; w++)
+            {
+                if (mask & (1u << w))
+                    base[index].words[w] ^= delta[k++];
+            }
+
+            if (!isTouched[index])
+            {
+                isTouched[index] = 1;
+                touched.push_back(index);
+            }
+        }
+
+        newest = (newest + capacity - 1) % capacity;
+        count--;
+    }
+    nextFrame = frame + 1;
+
+    for (unsigned int i = 0; i < touched.size(); i++)
+    {
+        unsigned int index = touched[i];
+        assert(world.bodies[index]->id == ids[index]);
+        Apply(base[index], world.bodies[index]);
+        isTouched[index] = 0;
+    }
+    touched.clear();
+
+    // contacts and events describe the step which was just undone; contacts are found again in the next step,
+    // and its events compare with pairs of the restored frame
+    world.contacts.clear();
+    world.stepIndex = frames[newest].stepIndex;
+    world.touching = frames[newest].touching;
+    world.overlaps = frames[newest].overlaps;
+    world.contactBegins.clear();
+    world.contactEnds.clear();
+    world.hits.clear();
+    world.sensorBegins.clear();
+    world.sensorEnds.clear();
+
+    // pairs of the next step are found with boxes of the restored transforms
+    world.RefreshBroadphase();
+
+    return true;
+}
+
+bool SnapshotBuffer::Contains(unsigned long long frame) const
+{
+    return count > 0 && frame >= OldestFrame() && frame <= NewestFrame();
+}
+
+unsigned int SnapshotBuffer::Count() const
+{
+    return count;
+}
+
+unsigned long long SnapshotBuffer::OldestFrame() const
+{
+    assert(count > 0);
+    return frames[newest].number - (count - 1);
+}
+
+unsigned long long SnapshotBuffer::NewestFrame() const
+{
+    assert(count > 0);
+    return frames[newest].number;
+}
+
+unsigned int SnapshotBuffer::ChangedBodies(unsigned long long frame) const
+{
+    return GetFrame(frame).changedBodies;
+}
+
+size_t SnapshotBuffer::FrameBytes(unsigned long long frame) const
+{
+    const Frame& stored = GetFrame(frame);
+    return stored.delta.size() * sizeof(uint32_t) + stored.touching.size() * sizeof(ContactEvent) + stored.overlaps.size() * sizeof(SensorEvent);
+}
+
+size_t SnapshotBuffer::BaseBytes() const
+{
+    return base.size() * sizeof(BodySnapshot) + ids.size() * sizeof(unsigned int);
+}
+
+size_t SnapshotBuffer::Bytes() const
+{
+    size_t bytes = BaseBytes();
+    for (unsigned int i = 0; i < frames.size(); i++)
+    {
+        bytes += frames[i].delta.capacity() * sizeof(uint32_t);
+        bytes += frames[i].touching.capacity() * sizeof(ContactEvent) + frames[i].overlaps.capacity() * sizeof(SensorEvent);
+    }
+    return bytes;
+}
+
+void SnapshotBuffer::Clear()
+{
+    count = 0;
+    newest = capacity - 1;
+    ids.clear();
+    base.clear();
+}
+
+const SnapshotBuffer::Frame& SnapshotBuffer::GetFrame(unsigned long long frame) const
+{
+    assert(Contains(frame));
+    unsigned int back = (unsigned int)(NewestFrame() - frame);
+    return frames[(newest + capacity - back) % capacity];
+}
@@ -0,0 +1,111 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#ifndef SNAPSHOTBUFFER_H
+#define SNAPSHOTBUFFER_H
+
+#include <cstdint>
+
+class World;
+
+// number of 32-bit words of saved body state:
+// position ( 2 ), velocity ( 2 ), angular velocity, orientation, force ( 2 ), torque,
+// category and mask of the filter, group of the filter and whether the body is a sensor
+const unsigned int snapshotWords = 11;
+
+
+// dynamic state of one body as raw bits of its floats
+struct BodySnapshot
+{
+    uint32_t words[snapshotWords];
+};
+
+
+// SnapshotBuffer class - ring buffer of world states of the last steps for rollback and resimulation
+// every frame keeps only XOR of state words of bodies which changed since the previous frame, so resting
+// and static bodies cost nothing; the state of the newest frame is kept in full and older frames are
+// reached by undoing deltas from the newest one
+// frames cover only dynamic state, filters and pairs which touched or overlapped sensors after the step,
+// so events of resimulated steps compare with the restored step; adding or removing bodies starts the buffer from scratch
+// saving compares every body with the newest frame, because bodies don't tell which of them changed;
+// only the changed ones are stored, and restoring touches only bodies changed after the restored frame
+class SnapshotBuffer
+{
+public:
+    // constructor
+    // _capacity - maximal number of stored frames
+    SnapshotBuffer(unsigned int _capacity);
+
+    // saves state of all bodies as a new frame; the oldest frame is dropped if the buffer is full
+    // returns number of the saved frame
+    // world - world to save
+    unsigned long long Save(const World& world);
+
+    // brings bodies and the step index back to the state of a saved frame and drops all newer frames
+    // the world has to be in the state of the newest frame, so Save is called after every step
+    // returns false if the frame is not stored anymore
+    // world - world to restore
+    // frame - number of the frame returned by Save
+    bool Restore(World& world, unsigned long long frame);
+
+    // checks whether frame is stored in the buffer
+    // frame - number of the frame returned by Save
+    bool Contains(unsigned long long frame) const;
+
+    // returns number of stored frames
+    unsigned int Count() const;
+
+    // returns number of the oldest stored frame
+    unsigned long long OldestFrame() const;
+
+    // returns number of the newest stored frame
+    unsigned long long NewestFrame() const;
+
+    // returns number of bodies which changed in a frame
+    // frame - number of stored frame
+    unsigned int ChangedBodies(unsigned long long frame) const;
+
+    // returns size of the delta of a frame in bytes
+    // frame - number of stored frame
+    size_t FrameBytes(unsigned long long frame) const;
+
+    // returns size of the full state of the newest frame in bytes
+    size_t BaseBytes() const;
+
+    // returns memory used by the whole buffer in bytes
+    size_t Bytes() const;
+
+    // drops all frames
+    void Clear();
+
+private:
+    // delta of one frame: for every changed body its index, mask of changed words and XOR of these words;
+    // touching pairs and overlaps of sensors are few, so they are stored whole
+    struct Frame
+    {
+        unsigned long long number;
+        unsigned long long stepIndex;   // World::stepIndex, by which commands are logged, replayed and published
+        unsigned int changedBodies;
+        std::vector<uint32_t> delta;
+        std::vector<ContactEvent> touching;
+        std::vector<SensorEvent> overlaps;
+    };
+
+    unsigned int capacity;
+    unsigned int count;
+    unsigned int newest;                // index of the newest frame in frames
+    unsigned long long nextFrame;
+    std::vector<Frame> frames;
+
+    std::vector<unsigned int> ids;      // ids of saved bodies in order of World::bodies
+    std::vector<BodySnapshot> base;     // state of the newest frame
+
+    std::vector<unsigned int> touched;
+    std::vector<char> isTouched;
+
+    // returns stored frame with given number
+    const Frame& GetFrame(unsigned long long frame) const;
+};
+
+#endif // SNAPSHOTBUFFER_H
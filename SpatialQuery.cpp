@@ -0,0 +1,231 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#include "IncludesManager.h"
+
+// number of queries executed by one job
+const unsigned int queryGrain = 64;
+
+
+// returns distance of point from surface of a body; 0 inside
+static float DistanceToBody(const Vector2D& point, const RigidBody* body)
+{
+    if (body->shape->GetType() == Shape::CircleID)
+        return std::max(0.0f, (point - body->position).length() - ((const Circle*)body->shape)->radius);
+    if (body->shape->GetType() == Shape::CapsuleID)
+    {
+        const Capsule* capsule = (const Capsule*)body->shape;
+        Vector2D a, b;
+        capsule->GetCore(a, b);
+        return std::max(0.0f, DistanceToSegment(point, a, b) - capsule->radius);
+    }
+    if (body->shape->GetType() == Shape::ChainID)
+        return ((const Chain*)body->shape)->Distance(point);
+
+    Vector2D corners[MaxPolyVertexCount];
+    int count = WorldVertices(body, corners);
+    return DistanceToPolygon(point, corners, count);
+}
+
+// returns whether a body overlaps convex polygon
+static bool OverlapsPolygon(const RigidBody* body, const Vector2D* vertices, int count)
+{
+    if (body->shape->GetType() == Shape::CircleID)
+        return DistanceToPolygon(body->position, vertices, count) <= ((const Circle*)body->shape)->radius;
+    if (body->shape->GetType() == Shape::CapsuleID)
+    {
+        const Capsule* capsule = (const Capsule*)body->shape;
+        Vector2D a, b;
+        capsule->GetCore(a, b);
+        return DistanceToPolygon(a, b, vertices, count) <= capsule->radius;
+    }
+    if (body->shape->GetType() == Shape::ChainID)
+        return ChainOverlapsPolygon(body, vertices, count);
+
+    Vector2D corners[MaxPolyVertexCount];
+    int corner = WorldVertices(body, corners);
+    return PolygonsOverlap(corners, corner, vertices, count);
+}
+
+static bool CompareIds(const RigidBody* a, const RigidBody* b)
+{
+    return a->id < b->id;
+}
+
+
+void QueryBatch::Clear()
+{
+    queries.clear();
+    vertices.clear();
+}
+
+unsigned int QueryBatch::AddPoint(const Vector2D& point)
+{
+    SpatialQuery query = { SpatialQuery::PointQuery, point, 0.0f, 0, 0 };
+    queries.push_back(query);
+    return (unsigned int)queries.size() - 1;
+}
+
+unsigned int QueryBatch::AddCircle(const Vector2D& center, float radius)
+{
+    SpatialQuery query = { SpatialQuery::CircleQuery, center, radius, 0, 0 };
+    queries.push_back(query);
+    return (unsigned int)queries.size() - 1;
+}
+
+unsigned int QueryBatch::AddPolygon(const Vector2D* polygon, unsigned int count)
+{
+    assert(count >= 3 && count <= MaxPolyVertexCount);
+    SpatialQuery query = { SpatialQuery::PolygonQuery, polygon[0], 0.0f, (unsigned int)vertices.size(), count };
+    vertices.insert(vertices.end(), polygon, polygon + count);
+    queries.push_back(query);
+    return (unsigned int)queries.size() - 1;
+}
+
+unsigned int QueryBatch::AddNearest(const Vector2D& point, unsigned int count, float maxDistance)
+{
+    SpatialQuery query = { SpatialQuery::NearestQuery, point, maxDistance, 0, count };
+    queries.push_back(query);
+    return (unsigned int)queries.size() - 1;
+}
+
+unsigned int QueryBatch::QueryCount() const
+{
+    return (unsigned int)queries.size();
+}
+
+void QueryBatch::Execute(const World& world, const SpatialQuery& query, Chunk& chunk) const
+{
+    const AABBTree& tree = world.broadphase;
+    size_t first = chunk.bodies.size();
+
+    switch (query.type)
+    {
+    case SpatialQuery::PointQuery:
+        tree.Query(AABB(query.point, query.point), [&](int proxy)
+        {
+            RigidBody* body = tree.GetBody(proxy);
+            if (body->shape->Contains(query.point))
+                chunk.bodies.push_back(body);
+            return true;
+        });
+        break;
+
+    case SpatialQuery::CircleQuery:
+    {
+        Vector2D extent(query.radius, query.radius);
+        tree.Query(AABB(query.point - extent, query.point + extent), [&](int proxy)
+        {
+            RigidBody* body = tree.GetBody(proxy);
+            if (DistanceToBody(query.point, body) <= query.radius)
+                chunk.bodies.push_back(body);
+            return true;
+        });
+    }
+    break;
+
+    case SpatialQuery::PolygonQuery:
+    {
+        const Vector2D* polygon = &vertices[query.first];
+        AABB box(polygon[0], polygon[0]);
+        for (unsigned int i = 1; i < query.count; i++)
+            box = box.Combine(AABB(polygon[i], polygon[i]));
+
+        tree.Query(box, [&](int proxy)
+        {
+            RigidBody* body = tree.GetBody(proxy);
+            if (body->shape->GetAABB().Overlaps(box) && OverlapsPolygon(body, polygon, query.count))
+                chunk.bodies.push_back(body);
+            return true;
+        });
+    }
+    break;
+
+    case SpatialQuery::NearestQuery:
+    {
+        chunk.nearest.clear();
+        Vector2D extent(query.radius, query.radius);
+        tree.Query(AABB(query.point - extent, query.point + extent), [&](int proxy)
+        {
+            RigidBody* body = tree.GetBody(proxy);
+            float distance = DistanceToBody(query.point, body);
+            if (distance <= query.radius)
+                chunk.nearest.push_back(std::make_pair(distance, body));
+            return true;
+        });
+
+        // equal distances are ordered by ids, so the result doesn't depend on the shape of the tree
+        unsigned int count = std::min<unsigned int>(query.count, (unsigned int)chunk.nearest.size());
+        std::partial_sort(chunk.nearest.begin(), chunk.nearest.begin() + count, chunk.nearest.end(),
+            [](const std::pair<float, RigidBody*>& a, const std::pair<float, RigidBody*>& b)
+        {
+            if (a.first != b.first)
+                return a.first < b.first;
+            return a.second->id < b.second->id;
+        });
+        for (unsigned int i = 0; i < count; i++)
+            chunk.bodies.push_back(chunk.nearest[i].second);
+        chunk.counts.push_back((unsigned int)(chunk.bodies.size() - first));
+        return;
+    }
+    }
+
+    std::sort(chunk.bodies.begin() + first, chunk.bodies.end(), CompareIds);
+    chunk.counts.push_back((unsigned int)(chunk.bodies.size() - first));
+}
+
+void QueryBatch::Run(const World& world, JobSystem& jobs)
+{
+    unsigned int count = (unsigned int)queries.size();
+    unsigned int chunkCount = (count + queryGrain - 1) / queryGrain;
+    if (chunks.size() < chunkCount)
+        chunks.resize(chunkCount);
+
+    jobs.ParallelFor(count, queryGrain, [&](unsigned int begin, unsigned int end)
+    {
+        Chunk& chunk = chunks[begin / queryGrain];
+        chunk.bodies.clear();
+        chunk.counts.clear();
+        for (unsigned int i = begin; i < end; i++)
+            Execute(world, queries[i], chunk);
+    });
+
+    // rows of chunks are joined in order of queries
+    offsets.resize(count + 1);
+    offsets[0] = 0;
+    chunkOffsets.resize(chunkCount);
+    for (unsigned int c = 0; c < chunkCount; c++)
+    {
+        chunkOffsets[c] = offsets[c * queryGrain];
+        for (unsigned int i = 0; i < chunks[c].counts.size(); i++)
+            offsets[c * queryGrain + i + 1] = offsets[c * queryGrain + i] + chunks[c].counts[i];
+    }
+    bodies.resize(offsets[count]);
+
+    jobs.ParallelFor(chunkCount, 1, [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int c = begin; c < end; c++)
+            std::copy(chunks[c].bodies.begin(), chunks[c].bodies.end(), bodies.begin() + chunkOffsets[c]);
+    });
+}
+
+unsigned int QueryBatch::ResultCount(unsigned int query) const
+{
+    return offsets[query + 1] - offsets[query];
+}
+
+RigidBody* const* QueryBatch::Results(unsigned int query) const
+{
+    return bodies.data() + offsets[query];
+}
+
+const std::vector<unsigned int>& QueryBatch::GetOffsets() const
+{
+    return offsets;
+}
+
+const std::vector<RigidBody*>& QueryBatch::GetBodies() const
+{
+    return bodies;
+}
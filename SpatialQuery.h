@@ -0,0 +1,104 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#ifndef SPATIALQUERY_H
+#define SPATIALQUERY_H
+
+class World;
+class RigidBody;
+class JobSystem;
+
+// one query of a batch
+struct SpatialQuery
+{
+    enum Type
+    {
+        PointQuery,     // bodies containing the point
+        CircleQuery,    // bodies overlapping the circle
+        PolygonQuery,   // bodies overlapping the convex polygon
+        NearestQuery,   // up to count bodies closest to the point, not further than radius
+    };
+
+    Type type;
+    Vector2D point;             // PointQuery, NearestQuery - tested point; CircleQuery - center
+    float radius;               // CircleQuery - radius; NearestQuery - the largest distance
+    unsigned int first;         // PolygonQuery - first vertex in the vertex list of the batch
+    unsigned int count;         // PolygonQuery - number of vertices; NearestQuery - number of wanted bodies
+};
+
+
+// QueryBatch class - runs many spatial queries at once on threads of a job system
+// queries only read the broadphase and bodies, which Step leaves up to date and unchanged until the next step,
+// so the world mustn't be stepped during Run; with SimulationThread the world has to be locked
+// results are stored as compressed rows: bodies found by query i are GetBodies()[GetOffsets()[i]]
+// up to GetBodies()[GetOffsets()[i + 1]]; buffers are reused, so a repeated batch doesn't allocate
+class QueryBatch
+{
+public:
+    // removes all queries
+    void Clear();
+
+    // adds query for bodies containing the point; returns index of the query
+    // point - tested point
+    unsigned int AddPoint(const Vector2D& point);
+
+    // adds query for bodies overlapping the circle; returns index of the query
+    // center - center of the circle
+    // radius - radius of the circle
+    unsigned int AddCircle(const Vector2D& center, float radius);
+
+    // adds query for bodies overlapping the convex polygon; returns index of the query
+    // vertices - vertices of the polygon in coordinates of the world, in order around the polygon
+    // count - number of vertices; between 3 and MaxPolyVertexCount
+    unsigned int AddPolygon(const Vector2D* vertices, unsigned int count);
+
+    // adds query for the nearest bodies; their distance is measured from the point to their surface
+    // returns index of the query
+    // point - tested point
+    // count - largest number of found bodies
+    // maxDistance - bodies further than this aren't found
+    unsigned int AddNearest(const Vector2D& point, unsigned int count, float maxDistance);
+
+    // returns number of queries
+    unsigned int QueryCount() const;
+
+    // runs all queries; bodies found by nearest queries are sorted by distance, by other queries by ids
+    // world - queried world
+    // jobs - job system executing queries
+    void Run(const World& world, JobSystem& jobs);
+
+    // returns number of bodies found by a query
+    unsigned int ResultCount(unsigned int query) const;
+
+    // returns first body found by a query
+    RigidBody* const* Results(unsigned int query) const;
+
+    // returns beginnings of results of queries; one more than queries, the last one is the number of all results
+    const std::vector<unsigned int>& GetOffsets() const;
+
+    // returns results of all queries one after another
+    const std::vector<RigidBody*>& GetBodies() const;
+
+private:
+    std::vector<SpatialQuery> queries;
+    std::vector<Vector2D> vertices;
+
+    std::vector<unsigned int> offsets;
+    std::vector<RigidBody*> bodies;
+
+    // results and their counts of every chunk of queries, joined after all chunks are done
+    struct Chunk
+    {
+        std::vector<RigidBody*> bodies;
+        std::vector<unsigned int> counts;
+        std::vector<std::pair<float, RigidBody*>> nearest;
+    };
+    std::vector<Chunk> chunks;
+    std::vector<unsigned int> chunkOffsets;
+
+    // runs one query and appends its results to the chunk
+    void Execute(const World& world, const SpatialQuery& query, Chunk& chunk) const;
+};
+
+#endif // SPATIALQUERY_H
@@ -8,7 +8,7 @@
 #include "IncludesManager.h"
 
 World scene(1.0f / 60.0f, 10);
-Timer clock;
+Timer frameClock;
 
 // mouse moves definition
 void mouse(int button, int state, int x, int y)
@@ -60,19 +60,19 @@ void loop()
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     static double accumulator = 0;
-    accumulator += clock.Time();
+    accumulator += frameClock.Time();
 
-    clock.Start();
+    frameClock.Start();
 
     accumulator = Clamp(0.0f, 0.1f, accumulator);
-    while (accumulator >= dt)
+    while (accumulator >= scene.settings.dt)
     {
         scene.Step();
-        accumulator -= dt;
+        accumulator -= scene.settings.dt;
     }
 
-    clock.Stop();
-    scene.Render();
+    frameClock.Stop();
+    scene.Render(AABB(Vector2D(0.0f, 0.0f), Vector2D(80.0f, 60.0f)));
     glutSwapBuffers();
 }
 
@@ -0,0 +1,168 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#include "IncludesManager.h"
+#include <cstdio>
+#include <memory>
+
+// events of one thread; only the owning thread writes, any thread reads published events
+struct TraceBuffer
+{
+    unsigned int index;                             // tid in the saved trace
+    std::atomic<unsigned int> published;
+    std::atomic<TraceEvent*> blocks[traceMaxBlocks];
+
+    TraceBuffer(unsigned int _index) : index(_index), published(0)
+    {
+        for (unsigned int i = 0; i < traceMaxBlocks; i++)
+            blocks[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~TraceBuffer()
+    {
+        for (unsigned int i = 0; i < traceMaxBlocks; i++)
+            delete[] blocks[i].load(std::memory_order_relaxed);
+    }
+};
+
+static std::atomic<bool> recording(false);
+static std::mutex buffersMutex;
+static std::vector<std::unique_ptr<TraceBuffer>> buffers;
+static thread_local TraceBuffer* threadBuffer = nullptr;
+
+// returns buffer of the current thread; it is created at the first event of the thread
+static TraceBuffer* GetThreadBuffer()
+{
+    if (!threadBuffer)
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        buffers.push_back(std::unique_ptr<TraceBuffer>(new TraceBuffer((unsigned int)buffers.size())));
+        threadBuffer = buffers.back().get();
+    }
+    return threadBuffer;
+}
+
+// writes name with characters which are special in JSON escaped
+static void WriteName(FILE* file, const char* name)
+{
+    for (const char* c = name; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+            fputc('\\', file);
+        if ((unsigned char)*c >= 0x20)
+            fputc(*c, file);
+    }
+}
+
+
+void TraceRecorder::Start()
+{
+    recording.store(true, std::memory_order_relaxed);
+}
+
+void TraceRecorder::Stop()
+{
+    recording.store(false, std::memory_order_relaxed);
+}
+
+bool TraceRecorder::IsRecording()
+{
+    return recording.load(std::memory_order_relaxed);
+}
+
+void TraceRecorder::Add(const char* name, long long start, long long end, unsigned int count)
+{
+    if (!IsRecording())
+        return;
+
+    TraceBuffer* buffer = GetThreadBuffer();
+    unsigned int n = buffer->published.load(std::memory_order_relaxed);
+    unsigned int block = n / traceBlockSize;
+    if (block >= traceMaxBlocks)
+        return;
+
+    TraceEvent* events = buffer->blocks[block].load(std::memory_order_relaxed);
+    if (!events)
+    {
+        events = new TraceEvent[traceBlockSize];
+        buffer->blocks[block].store(events, std::memory_order_relaxed);
+    }
+
+    TraceEvent& event = events[n % traceBlockSize];
+    event.name = name;
+    event.start = start;
+    event.end = end;
+    event.count = count;
+
+    // release makes the event and its block visible to a thread which sees the new counter
+    buffer->published.store(n + 1, std::memory_order_release);
+}
+
+bool TraceRecorder::Save(const char* path)
+{
+    FILE* file;
+    if (fopen_s(&file, path, "w") != 0)
+        return false;
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    double microsecondsPerTick = 1000000.0 / (double)frequency.QuadPart;
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+
+    // times are written relative to the earliest event, so they stay small and precise;
+    // an enclosing scope ends last, so the earliest event isn't always the first one of a buffer
+    // threads may still record, so only events published at this moment are saved
+    std::vector<unsigned int> counts(buffers.size());
+    long long origin = LLONG_MAX;
+    for (unsigned int i = 0; i < buffers.size(); i++)
+    {
+        TraceBuffer* buffer = buffers[i].get();
+        unsigned int n = counts[i] = buffer->published.load(std::memory_order_acquire);
+        for (unsigned int k = 0; k < n; k++)
+            origin = std::min(origin, buffer->blocks[k / traceBlockSize].load(std::memory_order_relaxed)[k % traceBlockSize].start);
+    }
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    bool first = true;
+    for (unsigned int i = 0; i < buffers.size(); i++)
+    {
+        TraceBuffer* buffer = buffers[i].get();
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"Thread %u\"}}",
+            first ? "" : ",\n", buffer->index, buffer->index);
+        first = false;
+
+        for (unsigned int k = 0; k < counts[i]; k++)
+        {
+            const TraceEvent& event = buffer->blocks[k / traceBlockSize].load(std::memory_order_relaxed)[k % traceBlockSize];
+
+            fprintf(file, ",\n{\"name\":\"");
+            WriteName(file, event.name);
+            fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+                buffer->index, (event.start - origin) * microsecondsPerTick, (event.end - event.start) * microsecondsPerTick);
+            if (event.count != traceNoCount)
+                fprintf(file, ",\"args\":{\"count\":%u}", event.count);
+            fprintf(file, "}");
+        }
+    }
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    return fclose(file) == 0;
+}
+
+void TraceRecorder::Clear()
+{
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (unsigned int i = 0; i < buffers.size(); i++)
+        buffers[i]->published.store(0, std::memory_order_relaxed);
+}
+
+unsigned long long TraceRecorder::EventCount()
+{
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    unsigned long long count = 0;
+    for (unsigned int i = 0; i < buffers.size(); i++)
+        count += buffers[i]->published.load(std::memory_order_relaxed);
+    return count;
+}
@@ -0,0 +1,95 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+// if we want to record timeline of the step
+#define RIGIDBODY_TRACE
+// if we want tracing compiled out - comment out the line above
+
+
+// one finished piece of work on a timeline
+struct TraceEvent
+{
+    const char* name;               // has to live as long as the recorder, usually a string literal
+    long long start;                // in performance counter ticks
+    long long end;
+    unsigned int count;             // number of processed elements or traceNoCount
+};
+
+const unsigned int traceNoCount = UINT_MAX;
+
+// events are stored in blocks, so a block never moves after it is published
+const unsigned int traceBlockSize = 4096;
+const unsigned int traceMaxBlocks = 1024;
+
+
+// TraceRecorder class - timeline of work of all threads which can be saved as Chrome trace JSON
+// every thread writes to its own buffer: it fills the next event and then publishes it by increasing
+// an atomic counter, so writing takes no lock and saving can read published events at any time
+// recording is off until Start is called; a thread stops recording when its buffer is full
+class TraceRecorder
+{
+public:
+    // starts recording events
+    static void Start();
+
+    // stops recording events; recorded events are kept
+    static void Stop();
+
+    // checks whether events are recorded
+    static bool IsRecording();
+
+    // adds an event of the current thread
+    // name - name of the event
+    // start - performance counter value at start of the work
+    // end - performance counter value at end of the work
+    // count - number of processed elements or traceNoCount
+    static void Add(const char* name, long long start, long long end, unsigned int count = traceNoCount);
+
+    // saves all published events as Chrome trace JSON, which is opened by chrome://tracing or Perfetto
+    // returns false if the file can't be written
+    // path - path of the file
+    static bool Save(const char* path);
+
+    // drops all events; no thread may record at the same time
+    static void Clear();
+
+    // returns number of events of all threads
+    static unsigned long long EventCount();
+};
+
+
+// TraceScope class - adds an event which lasts from its construction to its destruction
+class TraceScope
+{
+public:
+    TraceScope(const char* _name, unsigned int _count = traceNoCount)
+        : name(_name), count(_count), start(TraceRecorder::IsRecording() ? Profiler::Now() : 0)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (start)
+            TraceRecorder::Add(name, start, Profiler::Now(), count);
+    }
+
+private:
+    const char* name;
+    unsigned int count;
+    long long start;
+};
+
+
+#if defined(RIGIDBODY_TRACE)
+    #define TRACE_SCOPE(name) TraceScope traceScope((name))
+    #define TRACE_SCOPE_COUNT(name, count) TraceScope traceScope((name), (unsigned int)(count))
+#else
+    #define TRACE_SCOPE(name) ((void)0)
+    #define TRACE_SCOPE_COUNT(name, count) ((void)0)
+#endif
+
+#endif // TRACE_H
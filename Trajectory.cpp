@@ -0,0 +1,405 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#include "IncludesManager.h"
+
+static_assert(sizeof(TrajectoryFileHeader) == 24, "trajectory file header layout changed");
+static_assert(sizeof(TrajectoryChunkHeader) == 24, "trajectory chunk header layout changed");
+static_assert(sizeof(TrajectorySample) == 28, "trajectory sample layout changed");
+
+const unsigned int sampleWords = sizeof(TrajectorySample) / sizeof(uint32_t);
+
+
+// XORs words of every frame with words of the previous frame; the transform is its own inverse
+// when decoding is true the previous frame is taken from already decoded words
+// words - words of the chunk
+// frameCount - number of frames in the chunk
+// result - transformed words
+// frameOffsets - filled with index of the first word of every frame, if not nullptr
+// returns false if frames don't fit in the words
+static bool TransformChunk(const std::vector<uint32_t>& words, unsigned int frameCount, bool decoding,
+    std::vector<uint32_t>& result, std::vector<uint32_t>* frameOffsets)
+{
+    result.resize(words.size());
+    if (frameOffsets)
+        frameOffsets->clear();
+
+    size_t previous = 0, previousSize = 0;
+    size_t at = 0;
+    for (unsigned int f = 0; f < frameCount; f++)
+    {
+        if (at >= words.size())
+            return false;
+        if (frameOffsets)
+            frameOffsets->push_back((uint32_t)at);
+
+        // the number of bodies is XORed too, so it is known only after decoding
+        uint32_t previousCount = f > 0 ? (decoding ? result[previous] : words[previous]) : 0;
+        result[at] = words[at] ^ previousCount;
+        uint32_t bodyCount = decoding ? result[at] : words[at];
+
+        size_t size = (size_t)bodyCount * sampleWords;
+        if (words.size() - at - 1 < size)
+            return false;
+
+        for (size_t i = 0; i < size; i++)
+        {
+            uint32_t reference = i < previousSize ? (decoding ? result[previous + 1 + i] : words[previous + 1 + i]) : 0;
+            result[at + 1 + i] = words[at + 1 + i] ^ reference;
+        }
+
+        previous = at;
+        previousSize = size;
+        at += 1 + size;
+    }
+    return at == words.size();
+}
+
+// returns number of low bytes of the word which are needed to write it
+static unsigned int ByteLength(uint32_t word)
+{
+    unsigned int length = 0;
+    while (word)
+    {
+        length++;
+        word >>= 8;
+    }
+    return length;
+}
+
+// writes every pair of words as a byte with their lengths followed by their low non-zero bytes
+static void Pack(const std::vector<uint32_t>& words, std::vector<uint8_t>& bytes)
+{
+    bytes.clear();
+    bytes.reserve(words.size() * 2);
+    for (size_t i = 0; i < words.size(); i += 2)
+    {
+        uint32_t first = words[i];
+        uint32_t second = i + 1 < words.size() ? words[i + 1] : 0;
+        unsigned int firstLength = ByteLength(first);
+        unsigned int secondLength = ByteLength(second);
+
+        bytes.push_back((uint8_t)(firstLength | secondLength << 4));
+        for (unsigned int b = 0; b < firstLength; b++)
+            bytes.push_back((uint8_t)(first >> (8 * b)));
+        for (unsigned int b = 0; b < secondLength; b++)
+            bytes.push_back((uint8_t)(second >> (8 * b)));
+    }
+}
+
+// reverses Pack; returns false if bytes don't describe wordCount words
+static bool Unpack(const std::vector<uint8_t>& bytes, uint32_t wordCount, std::vector<uint32_t>& words)
+{
+    words.resize(wordCount);
+    size_t at = 0;
+    for (size_t i = 0; i < wordCount; i += 2)
+    {
+        if (at >= bytes.size())
+            return false;
+        unsigned int lengths[2] = { (unsigned int)(bytes[at] & 0xF), (unsigned int)(bytes[at] >> 4) };
+        at++;
+
+        for (unsigned int k = 0; k < 2; k++)
+        {
+            if (lengths[k] > 4 || bytes.size() - at < lengths[k])
+                return false;
+
+            uint32_t word = 0;
+            for (unsigned int b = 0; b < lengths[k]; b++)
+                word |= (uint32_t)bytes[at++] << (8 * b);
+            if (i + k < wordCount)
+                words[i + k] = word;
+        }
+    }
+    return at == bytes.size();
+}
+
+
+TrajectoryRecorder::TrajectoryRecorder(unsigned int _framesPerChunk)
+{
+    assert(_framesPerChunk > 0);
+    file = nullptr;
+    framesPerChunk = _framesPerChunk;
+    frameCount = 0;
+    currentFrames = 0;
+    stopping = false;
+    failed = false;
+}
+
+TrajectoryRecorder::~TrajectoryRecorder()
+{
+    Close();
+}
+
+bool TrajectoryRecorder::Open(const char* path, float dt)
+{
+    Close();
+
+    if (fopen_s(&file, path, "wb") != 0)
+    {
+        file = nullptr;
+        return false;
+    }
+
+    TrajectoryFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, trajectoryFileMagic, sizeof(header.magic));
+    header.version = trajectoryFileVersion;
+    header.byteOrder = worldFileByteOrder;
+    header.dt = dt;
+    header.framesPerChunk = framesPerChunk;
+    if (fwrite(&header, sizeof(header), 1, file) != 1)
+    {
+        fclose(file);
+        file = nullptr;
+        return false;
+    }
+
+    frameCount = 0;
+    currentFrames = 0;
+    current.clear();
+    stopping = false;
+    failed = false;
+    writer = std::thread(&TrajectoryRecorder::Write, this);
+    return true;
+}
+
+bool TrajectoryRecorder::Close()
+{
+    if (!file)
+        return true;
+
+    if (currentFrames > 0)
+        Submit();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_one();
+    writer.join();
+
+    bool closed = fclose(file) == 0;
+    file = nullptr;
+    return closed && !failed;
+}
+
+void TrajectoryRecorder::Record(const World& world)
+{
+    if (!file)
+        return;
+
+    // samples are copied as they are; the work of compressing is left to the writing thread
+    size_t at = current.size();
+    current.resize(at + 1 + world.bodies.size() * sampleWords);
+    current[at] = (uint32_t)world.bodies.size();
+
+    TrajectorySample* samples = (TrajectorySample*)&current[at + 1];
+    for (unsigned int i = 0; i < world.bodies.size(); i++)
+    {
+        const RigidBody* b = world.bodies[i];
+        TrajectorySample& sample = samples[i];
+        sample.id = b->id;
+        sample.position[0] = b->position.x;
+        sample.position[1] = b->position.y;
+        sample.orientation = b->orientation;
+        sample.velocity[0] = b->velocity.x;
+        sample.velocity[1] = b->velocity.y;
+        sample.angularVelocity = b->angularVelocity;
+    }
+
+    frameCount++;
+    if (++currentFrames == framesPerChunk)
+        Submit();
+}
+
+unsigned long long TrajectoryRecorder::FrameCount() const
+{
+    return frameCount;
+}
+
+void TrajectoryRecorder::Submit()
+{
+    Chunk chunk;
+    chunk.firstFrame = frameCount - currentFrames;
+    chunk.frameCount = currentFrames;
+    chunk.words.swap(current);
+    currentFrames = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(std::move(chunk));
+
+        // buffers are reused, so recording doesn't allocate after the first chunks
+        if (!spare.empty())
+        {
+            current.swap(spare.back());
+            spare.pop_back();
+        }
+    }
+    cv.notify_one();
+}
+
+void TrajectoryRecorder::Write()
+{
+    std::vector<uint32_t> transformed;
+    std::vector<uint8_t> bytes;
+
+    for (;;)
+    {
+        Chunk chunk;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (pending.empty())
+                return;
+            chunk = std::move(pending.front());
+            pending.pop_front();
+        }
+
+        bool valid = TransformChunk(chunk.words, chunk.frameCount, false, transformed, nullptr);
+        assert(valid);
+        (void)valid;
+        Pack(transformed, bytes);
+
+        TrajectoryChunkHeader header;
+        header.magic = trajectoryChunkMagic;
+        header.frameCount = chunk.frameCount;
+        header.firstFrame = chunk.firstFrame;
+        header.wordCount = (uint32_t)chunk.words.size();
+        header.byteCount = (uint32_t)bytes.size();
+
+        // after a failed write the file ends with a cut chunk, which readers ignore, so later chunks aren't written
+        if (!failed && (fwrite(&header, sizeof(header), 1, file) != 1 || fwrite(bytes.data(), 1, bytes.size(), file) != bytes.size()))
+            failed = true;
+
+        chunk.words.clear();
+        std::lock_guard<std::mutex> lock(mutex);
+        spare.push_back(std::move(chunk.words));
+    }
+}
+
+
+TrajectoryReader::TrajectoryReader()
+{
+    file = nullptr;
+    cachedChunk = -1;
+}
+
+TrajectoryReader::~TrajectoryReader()
+{
+    Close();
+}
+
+bool TrajectoryReader::Open(const char* path)
+{
+    Close();
+
+    if (fopen_s(&file, path, "rb") != 0)
+    {
+        file = nullptr;
+        return false;
+    }
+
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, trajectoryFileMagic, sizeof(header.magic)) != 0 ||
+        header.version != trajectoryFileVersion || header.byteOrder != worldFileByteOrder)
+    {
+        Close();
+        return false;
+    }
+
+    // only headers are read here; chunks are skipped and decoded when a frame inside them is needed
+    uint64_t offset = sizeof(header);
+    uint64_t nextFrame = 0;
+    _fseeki64(file, 0, SEEK_END);
+    uint64_t fileSize = (uint64_t)_ftelli64(file);
+
+    for (;;)
+    {
+        TrajectoryChunkHeader chunkHeader;
+        if (fileSize - offset < sizeof(chunkHeader))
+            break;
+        _fseeki64(file, (long long)offset, SEEK_SET);
+        if (fread(&chunkHeader, sizeof(chunkHeader), 1, file) != 1)
+            break;
+        if (chunkHeader.magic != trajectoryChunkMagic || chunkHeader.firstFrame != nextFrame ||
+            fileSize - offset - sizeof(chunkHeader) < chunkHeader.byteCount)
+            break;
+
+        ChunkInfo info;
+        info.offset = offset + sizeof(chunkHeader);
+        info.firstFrame = chunkHeader.firstFrame;
+        info.frameCount = chunkHeader.frameCount;
+        info.wordCount = chunkHeader.wordCount;
+        info.byteCount = chunkHeader.byteCount;
+        chunks.push_back(info);
+
+        nextFrame += chunkHeader.frameCount;
+        offset = info.offset + chunkHeader.byteCount;
+    }
+
+    return true;
+}
+
+void TrajectoryReader::Close()
+{
+    if (file)
+        fclose(file);
+    file = nullptr;
+    chunks.clear();
+    cachedChunk = -1;
+}
+
+unsigned long long TrajectoryReader::FrameCount() const
+{
+    if (chunks.empty())
+        return 0;
+    return chunks.back().firstFrame + chunks.back().frameCount;
+}
+
+float TrajectoryReader::GetDt() const
+{
+    return header.dt;
+}
+
+bool TrajectoryReader::ReadFrame(unsigned long long frame, std::vector<TrajectorySample>& samples)
+{
+    if (frame >= FrameCount())
+        return false;
+
+    std::vector<ChunkInfo>::const_iterator it = std::upper_bound(chunks.begin(), chunks.end(), frame,
+        [](unsigned long long value, const ChunkInfo& chunk) { return value < chunk.firstFrame; });
+    int index = (int)(it - chunks.begin()) - 1;
+    if (!LoadChunk(index))
+        return false;
+
+    uint32_t at = frameOffsets[(size_t)(frame - chunks[index].firstFrame)];
+    uint32_t bodyCount = words[at];
+    samples.resize(bodyCount);
+    if (bodyCount)
+        memcpy(samples.data(), &words[at + 1], bodyCount * sizeof(TrajectorySample));
+    return true;
+}
+
+bool TrajectoryReader::LoadChunk(int index)
+{
+    if (index == cachedChunk)
+        return true;
+    cachedChunk = -1;
+
+    const ChunkInfo& chunk = chunks[index];
+    bytes.resize(chunk.byteCount);
+    _fseeki64(file, (long long)chunk.offset, SEEK_SET);
+    if (fread(bytes.data(), 1, bytes.size(), file) != bytes.size())
+        return false;
+
+    std::vector<uint32_t> transformed;
+    if (!Unpack(bytes, chunk.wordCount, transformed))
+        return false;
+    if (!TransformChunk(transformed, chunk.frameCount, true, words, &frameOffsets))
+        return false;
+
+    cachedChunk = index;
+    return true;
+}
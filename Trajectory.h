@@ -0,0 +1,180 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+
+class World;
+
+// binary trajectory file format
+// the file is append-only: a header followed by independent chunks of consecutive frames
+//
+//   TrajectoryFileHeader
+//   TrajectoryChunkHeader, compressed words of the chunk
+//   TrajectoryChunkHeader, compressed words of the chunk
+//   ...
+//
+// words of a chunk are, for every frame, the number of bodies and their samples; every word is XORed
+// with the word at the same place of the previous frame of the chunk, so words of slowly moving bodies
+// have only a few low non-zero bytes; then every pair of words is written as one byte with the numbers
+// of their non-zero low bytes followed by these bytes
+// the first frame of a chunk is XORed with zeros, so every chunk is decoded without the previous ones
+
+const char trajectoryFileMagic[8] = { 'R', 'B', '2', 'D', 'T', 'R', 'A', 'J' };
+const uint32_t trajectoryFileVersion = 1;
+const uint32_t trajectoryChunkMagic = 0x4B4E4843;       // "CHNK"
+
+
+struct TrajectoryFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;             // worldFileByteOrder as written by the recording machine
+    float dt;                       // length of a step in [ second ]
+    uint32_t framesPerChunk;
+};
+
+
+struct TrajectoryChunkHeader
+{
+    uint32_t magic;
+    uint32_t frameCount;
+    uint64_t firstFrame;
+    uint32_t wordCount;             // number of words before compression
+    uint32_t byteCount;             // number of bytes after compression
+};
+
+
+// transform and velocities of one body in one frame
+struct TrajectorySample
+{
+    uint32_t id;
+    float position[2];
+    float orientation;
+    float velocity[2];
+    float angularVelocity;
+};
+
+
+// TrajectoryRecorder class - appends body transforms and velocities of every step to a trajectory file
+// the simulating thread only copies samples; full chunks are compressed and written by a background thread
+class TrajectoryRecorder
+{
+public:
+    // constructor
+    // _framesPerChunk - number of frames in one chunk; smaller chunks make seeking cheaper and compression worse
+    TrajectoryRecorder(unsigned int _framesPerChunk = 64);
+
+    // destructor - writes recorded frames and closes the file
+    ~TrajectoryRecorder();
+
+    // creates the file and starts the writing thread; returns false if the file can't be created
+    // path - path of the file
+    // dt - length of a step in [ second ] written to the header
+    bool Open(const char* path, float dt);
+
+    // writes recorded frames, stops the writing thread and closes the file
+    // returns false if some chunk couldn't be written, e.g. on a full disk; the file then holds only the chunks before it
+    bool Close();
+
+    // appends state of all bodies as the next frame; called after every step
+    // world - recorded world
+    void Record(const World& world);
+
+    // returns number of recorded frames
+    unsigned long long FrameCount() const;
+
+private:
+    FILE* file;
+    unsigned int framesPerChunk;
+    unsigned long long frameCount;
+
+    // chunk filled by the simulating thread
+    std::vector<uint32_t> current;
+    unsigned int currentFrames;
+
+    // full chunks waiting for the writing thread and buffers which can be filled again
+    struct Chunk
+    {
+        uint64_t firstFrame;
+        uint32_t frameCount;
+        std::vector<uint32_t> words;
+    };
+    std::deque<Chunk> pending;
+    std::vector<std::vector<uint32_t>> spare;
+
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping;
+    bool failed;                    // set by the writing thread and read after it is joined
+
+    // hands the current chunk over to the writing thread
+    void Submit();
+
+    // compresses and writes chunks until the recorder is closed
+    void Write();
+};
+
+
+// TrajectoryReader class - reads any frame of a trajectory file
+// chunk headers are indexed when the file is opened and the last decoded chunk is kept,
+// so reading frames in order decodes every chunk once
+class TrajectoryReader
+{
+public:
+    // constructor
+    TrajectoryReader();
+
+    // destructor - closes the file
+    ~TrajectoryReader();
+
+    // opens a trajectory file and indexes its chunks; returns false if the file is missing or invalid
+    // a chunk cut by an interrupted recording is ignored
+    // path - path of the file
+    bool Open(const char* path);
+
+    // closes the file
+    void Close();
+
+    // returns number of frames in the file
+    unsigned long long FrameCount() const;
+
+    // returns length of a step in [ second ]
+    float GetDt() const;
+
+    // reads samples of all bodies in a frame; returns false if the frame doesn't exist or its chunk is damaged
+    // frame - number of the frame, counting from 0
+    // samples - filled with samples of the frame in order of body ids
+    bool ReadFrame(unsigned long long frame, std::vector<TrajectorySample>& samples);
+
+private:
+    struct ChunkInfo
+    {
+        uint64_t offset;            // offset of compressed words in the file
+        uint64_t firstFrame;
+        uint32_t frameCount;
+        uint32_t wordCount;
+        uint32_t byteCount;
+    };
+
+    FILE* file;
+    TrajectoryFileHeader header;
+    std::vector<ChunkInfo> chunks;
+
+    // decoded chunk
+    int cachedChunk;
+    std::vector<uint8_t> bytes;
+    std::vector<uint32_t> words;
+    std::vector<uint32_t> frameOffsets;
+
+    // reads and decodes a chunk unless it is cached; returns false if the chunk is damaged
+    bool LoadChunk(int index);
+};
+
+#endif // TRAJECTORY_H
@@ -0,0 +1,100 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#ifndef VIEWER_H
+#define VIEWER_H
+
+#include "IncludesManager.h"
+
+// reference consumer of SharedStateExport - draws bodies simulated by another process
+// the viewer only maps the memory, so the simulating process doesn't know whether anybody watches
+
+SharedStateView sharedView;
+SharedFrame sharedFrame;
+
+void viewerLoop()
+{
+    // the previous frame stays on the screen when the simulation hasn't published anything new
+    if (!sharedView.Read(sharedFrame))
+        return;
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    for (unsigned int i = 0; i < sharedFrame.bodies.size(); i++)
+    {
+        const SharedBody& body = sharedFrame.bodies[i];
+        Vector2D position(body.position[0], body.position[1]);
+        Color color;
+        color.red = body.color[0];
+        color.green = body.color[1];
+        color.blue = body.color[2];
+
+        if (body.shapeType == Shape::CircleID)
+        {
+            Circle circle(body.radius);
+            circle.DrawAt(position, body.orientation, color);
+            continue;
+        }
+        if (body.shapeType == Shape::CapsuleID)
+        {
+            Capsule capsule(body.halfLength, body.radius);
+            capsule.DrawAt(position, body.orientation, color);
+            continue;
+        }
+
+        const float* vertices = sharedView.GetVertices(body);
+        if (!vertices)
+            continue;
+
+        Matrix2X2 rotation(body.orientation);
+        glColor3f(color.red, color.green, color.blue);
+        glBegin(body.shapeType != Shape::ChainID ? GL_POLYGON : body.isLoop ? GL_LINE_LOOP : GL_LINE_STRIP);
+        for (uint32_t v = 0; v < body.vertexCount; v++)
+        {
+            Vector2D point = position + rotation * Vector2D(vertices[2 * v], vertices[2 * v + 1]);
+            glVertex2f(point.x, point.y);
+        }
+        glEnd();
+    }
+    glutSwapBuffers();
+}
+
+void viewerKeyboard(unsigned char key, int x, int y)
+{
+    if (key == 27)
+        exit(0);
+}
+
+
+// Viewer - window which draws a world published by RigidBody2D --export
+// name - name of the shared memory
+// returns exit code of the program
+int InitViewer(int argc, char** argv, const char* name)
+{
+    if (!sharedView.Open(name))
+    {
+        fprintf(stderr, "can't open shared memory %s\n", name);
+        return 1;
+    }
+
+    glutInit(&argc, argv);
+    glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE);
+    glutInitWindowSize(800, 600);
+    glutCreateWindow("Rigid Body 2D Simulator: Viewer");
+    glutDisplayFunc(viewerLoop);
+    glutKeyboardFunc(viewerKeyboard);
+    glutIdleFunc(viewerLoop);
+
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    gluOrtho2D(0, 80, 60, 0);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    glutMainLoop();
+    return 0;
+}
+
+#endif // VIEWER_H
@@ -5,69 +5,659 @@
 #include "IncludesManager.h"
 #include "Physics.h"
 
+// number of elements processed by one job
+const unsigned int bodyGrain = 256;
+const unsigned int pairGrain = 64;
+const unsigned int contactGrain = 256;
+const unsigned int broadphaseGrain = 32;
+
+
 World::World(float _dt, unsigned int _iterations)
 {
-    dt = _dt;
-    iterations = _iterations;
+    settings.dt = _dt;
+    settings.iterations = _iterations;
+    jobs = nullptr;
+    recorder = nullptr;
+    inputLog = nullptr;
+    exporter = nullptr;
+    nextBodyId = 1;
+    stepIndex = 0;
+    hitThreshold = FLT_MAX;
+}
+
+World::World(const WorldSettings& _settings)
+{
+    settings = _settings;
+    jobs = nullptr;
+    recorder = nullptr;
+    inputLog = nullptr;
+    exporter = nullptr;
+    nextBodyId = 1;
+    stepIndex = 0;
+    hitThreshold = FLT_MAX;
+}
+
+World::~World()
+{
+    for (unsigned int i = 0; i < bodies.size(); i++)
+        delete bodies[i];
+    for (unsigned int i = 0; i < removedBodies.size(); i++)
+        delete removedBodies[i];
 }
 
 RigidBody* World::Add(Shape* shape, int x, int y)
 {
     assert(shape);
     RigidBody* b = new RigidBody(shape, x, y, 0, 73, 34, 1);
+    b->id = nextBodyId++;
+    b->proxy = broadphase.CreateProxy(b->shape->GetAABB(), b);
     bodies.push_back(b);
     return b;
 }
 
+// creates body described by definition without adding it to the world
+static RigidBody* CreateBody(const Shape* shape, const BodyDefinition& definition)
+{
+    RigidBody* b = new RigidBody((Shape*)shape, definition.position.x, definition.position.y, definition.orientation, 0, 0, definition.density);
+    b->SetVelocity(definition.velocity, definition.angularVelocity);
+    b->SetFrictions(definition.staticFriction, definition.kineticFriction, definition.restitution);
+    b->SetColor(definition.color.red, definition.color.green, definition.color.blue);
+    b->SetFilter(definition.filter);
+    b->isSensor = definition.isSensor;
+    if (definition.isStatic)
+        b->SetStatic();
+    return b;
+}
+
+RigidBody* World::Add(const Shape* shape, const BodyDefinition& definition)
+{
+    assert(shape);
+    RigidBody* b = CreateBody(shape, definition);
+    b->id = nextBodyId++;
+    b->proxy = broadphase.CreateProxy(b->shape->GetAABB(), b);
+    bodies.push_back(b);
+    return b;
+}
+
+unsigned int World::AddBatch(const Shape* const* shapes, const BodyDefinition* definitions, unsigned int count)
+{
+    unsigned int first = (unsigned int)bodies.size();
+    bodies.resize(first + count);
+
+    // copying shapes and calculating mass properties are independent for every body
+    JobSystem& js = jobs ? *jobs : JobSystem::Serial();
+    js.ParallelFor(count, bodyGrain, [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int i = begin; i < end; i++)
+        {
+            assert(shapes[i]);
+            bodies[first + i] = CreateBody(shapes[i], definitions[i]);
+        }
+    });
+
+    // ids and leaves are given in order, so the result doesn't depend on number of threads
+    for (unsigned int i = first; i < bodies.size(); i++)
+    {
+        RigidBody* b = bodies[i];
+        b->id = nextBodyId++;
+        b->proxy = broadphase.CreateDetachedProxy(b->shape->GetAABB(), b);
+    }
+    broadphase.Rebuild();
+
+    return first;
+}
+
+void World::Remove(RigidBody* body)
+{
+    std::vector<RigidBody*>::iterator it = std::find(bodies.begin(), bodies.end(), body);
+    assert(it != bodies.end());
+    bodies.erase(it);
+    broadphase.DestroyProxy(body->proxy);
+    body->proxy = -1;
+    removedBodies.push_back(body);
+}
+
+RigidBody* World::Find(unsigned int id)
+{
+    // bodies are added with increasing ids and removing keeps the order
+    std::vector<RigidBody*>::iterator it = std::lower_bound(bodies.begin(), bodies.end(), id,
+        [](const RigidBody* body, unsigned int value) { return body->id < value; });
+    if (it == bodies.end() || (*it)->id != id)
+        return nullptr;
+    return *it;
+}
+
+void World::SetJobSystem(JobSystem* _jobs)
+{
+    jobs = _jobs;
+}
+
+void World::SetRecorder(TrajectoryRecorder* _recorder)
+{
+    recorder = _recorder;
+}
+
+void World::SetExporter(SharedStateExport* _exporter)
+{
+    exporter = _exporter;
+}
+
+void World::SetInputLog(InputLog* _inputLog)
+{
+    inputLog = _inputLog;
+}
+
 void World::Step()
 {
-    contacts.clear();
-    for (int i = 0; i < bodies.size(); i++)
+    PROFILE_BEGIN_STEP(profiler);
+
+    for (unsigned int i = 0; i < removedBodies.size(); i++)
+        delete removedBodies[i];
+    removedBodies.clear();
+
+    ApplyCommands();
+
+    JobSystem& js = jobs ? *jobs : JobSystem::Serial();
+
+    // pairs -> narrowphase -> contact preparation -> forces -> solver -> velocities -> position correction -> broadphase update
+    //                                                                                  -> clearing forces
+    // sensors are tested after pairs alongside the narrowphase and finish before velocities move bodies,
+    // contact events are reported from solved contacts alongside the rest of the step
+    // the tree is updated once, after bodies moved; it stays current for queries and pairs of the next step,
+    // because added bodies get their boxes on insertion and other changes call RefreshBroadphase
+    JobGraph graph;
+    int pairing = graph.Add([&] { FindPairs(js); });
+    int narrowphase = graph.Add([&] { Collide(js); });
+    int sensing = graph.Add([&] { DetectSensors(js); });
+    int prepare = graph.Add([&] { PrepareContacts(js); });
+    int forces = graph.Add([&] { IntegrateForces(js); });
+    int solve = graph.Add([&] { SolveContacts(); });
+    int report = graph.Add([&] { ReportContacts(); });
+    int velocities = graph.Add([&] { IntegrateVelocities(js); });
+    int correct = graph.Add([&] { CorrectPositions(); });
+    int clear = graph.Add([&] { ClearForces(js); });
+    int update = graph.Add([&] { UpdateBroadphase(js); });
+
+    graph.Depend(pairing, narrowphase);
+    graph.Depend(pairing, sensing);
+    graph.Depend(sensing, velocities);
+    graph.Depend(narrowphase, prepare);
+    graph.Depend(prepare, forces);
+    graph.Depend(forces, solve);
+    graph.Depend(solve, report);
+    graph.Depend(solve, velocities);
+    graph.Depend(velocities, correct);
+    graph.Depend(velocities, clear);
+    graph.Depend(correct, update);
+
+    graph.Run(js);
+
+    if (recorder)
+        recorder->Record(*this);
+
+    stepIndex++;
+
+    if (exporter)
+        exporter->Publish(*this);
+
+    PROFILE_END_STEP(profiler);
+}
+
+void World::ApplyCommands()
+{
+    PROFILE_SCOPE(profiler, PhaseCommands);
+    Command* list = commands.TakeAll();
+    if (!list)
+        return;
+
+    unsigned int added = 0;
+    for (Command* command = list; command; command = command->next)
+    {
+        if (command->type == Command::AddBody)
+            added++;
+    }
+    bodies.reserve(bodies.size() + added);
+
+    // removed bodies are only marked and dropped in one pass, so removing many bodies is linear
+    std::vector<RigidBody*> marked;
+    for (Command* command = list; command; command = command->next)
+    {
+        if (inputLog)
+            inputLog->Record(stepIndex, *command);
+
+        if (command->type == Command::AddBody)
+        {
+            Add(command->shape, command->definition);
+            continue;
+        }
+
+        RigidBody* body = Find(command->bodyId);
+        if (!body)
+            continue;
+
+        switch (command->type)
+        {
+        case Command::RemoveBody:
+            marked.push_back(body);
+            break;
+        case Command::ApplyImpulse:
+            body->ApplyImpulse(command->vector, command->contactVector);
+            break;
+        case Command::SetVelocity:
+            body->SetVelocity(command->vector, command->angularVelocity);
+            break;
+        case Command::SetFilter:
+            body->SetFilter(command->filter);
+            break;
+        default:
+            break;
+        }
+    }
+    CommandQueue::Release(list);
+
+    if (inputLog)
+        inputLog->Flush();
+
+    if (marked.empty())
+        return;
+
+    std::sort(marked.begin(), marked.end());
+    marked.erase(std::unique(marked.begin(), marked.end()), marked.end());
+    bodies.erase(std::remove_if(bodies.begin(), bodies.end(),
+        [&](RigidBody* body) { return std::binary_search(marked.begin(), marked.end(), body); }), bodies.end());
+    for (unsigned int i = 0; i < marked.size(); i++)
+    {
+        broadphase.DestroyProxy(marked[i]->proxy);
+        marked[i]->proxy = -1;
+    }
+    removedBodies.insert(removedBodies.end(), marked.begin(), marked.end());
+}
+
+void World::UpdateBroadphase(JobSystem& js)
+{
+    PROFILE_SCOPE(profiler, PhaseBroadphase);
+    boxes.resize(bodies.size());
+    js.ParallelFor((unsigned int)bodies.size(), bodyGrain, [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int i = begin; i < end; i++)
+            boxes[i] = bodies[i]->shape->GetAABB();
+    });
+
+    // only bodies which left their fat boxes change the tree
+    for (unsigned int i = 0; i < bodies.size(); i++)
+        broadphase.MoveProxy(bodies[i]->proxy, boxes[i]);
+}
+
+void World::FindPairs(JobSystem& js)
+{
+    PROFILE_SCOPE(profiler, PhasePairs);
+    unsigned int count = (unsigned int)bodies.size();
+    chunkPairs.resize((count + broadphaseGrain - 1) / broadphaseGrain);
+
+    js.ParallelFor(count, broadphaseGrain, [&](unsigned int begin, unsigned int end)
+    {
+        TRACE_SCOPE_COUNT("PairBucket", end - begin);
+        std::vector<BodyPair>& chunk = chunkPairs[begin / broadphaseGrain];
+        chunk.clear();
+        for (unsigned int i = begin; i < end; i++)
+        {
+            RigidBody* A = bodies[i];
+
+            // static bodies don't look for pairs; they are found by moving bodies
+            if (A->inverseMass == 0)
+                continue;
+
+            broadphase.Query(broadphase.GetFatAABB(A->proxy), [&](int proxy)
+            {
+                RigidBody* B = broadphase.GetBody(proxy);
+
+                // a pair of moving bodies is found twice, so only the body with the smaller id keeps it
+                if (B == A || (B->inverseMass != 0 && B->id < A->id))
+                    return true;
+
+                // filtered pairs never reach the narrowphase; sensors don't sense each other
+                if (!ShouldCollide(A->filter, B->filter) || (A->isSensor && B->isSensor))
+                    return true;
+
+                if (A->id < B->id)
+                    chunk.push_back(BodyPair{ A, B });
+                else
+                    chunk.push_back(BodyPair{ B, A });
+                return true;
+            });
+        }
+    });
+
+    pairs.clear();
+    for (unsigned int i = 0; i < chunkPairs.size(); i++)
+        pairs.insert(pairs.end(), chunkPairs[i].begin(), chunkPairs[i].end());
+
+    // pairs are sorted by ids, so they are solved in the same order for any number of threads
+    std::sort(pairs.begin(), pairs.end(), [](const BodyPair& a, const BodyPair& b)
+    {
+        if (a.bodyA->id != b.bodyA->id)
+            return a.bodyA->id < b.bodyA->id;
+        return a.bodyB->id < b.bodyB->id;
+    });
+
+    // pairs with a sensor are only tested for overlap, so they are moved out of the narrowphase keeping the order
+    sensorPairs.clear();
+    unsigned int kept = 0;
+    for (unsigned int i = 0; i < pairs.size(); i++)
     {
-        RigidBody* A = bodies[i];
+        if (pairs[i].bodyA->isSensor || pairs[i].bodyB->isSensor)
+            sensorPairs.push_back(pairs[i]);
+        else
+            pairs[kept++] = pairs[i];
+    }
+    pairs.resize(kept);
 
-        for (int j = i + 1; j < bodies.size(); j++)
+    PROFILE_COUNT(profiler, CounterPairsTested, pairs.size());
+}
+
+void World::Collide(JobSystem& js)
+{
+    PROFILE_SCOPE(profiler, PhaseNarrowphase);
+    unsigned int count = (unsigned int)pairs.size();
+    chunkContacts.resize((count + pairGrain - 1) / pairGrain);
+
+    js.ParallelFor(count, pairGrain, [&](unsigned int begin, unsigned int end)
+    {
+        TRACE_SCOPE_COUNT("NarrowphaseBucket", end - begin);
+        std::vector<ContactPoint>& chunk = chunkContacts[begin / pairGrain];
+        chunk.clear();
+        for (unsigned int i = begin; i < end; i++)
         {
-            RigidBody* B = bodies[j];
-            if (A->inverseMass == 0 && B->inverseMass == 0)
+            // a chain touches a body with as many contacts as touched segments
+            if (pairs[i].bodyA->shape->GetType() == Shape::ChainID || pairs[i].bodyB->shape->GetType() == Shape::ChainID)
+            {
+                ChainToShape(pairs[i].bodyA, pairs[i].bodyB, settings.dt, chunk);
                 continue;
-            ContactPoint m(A, B);
+            }
+
+            ContactPoint m(pairs[i].bodyA, pairs[i].bodyB);
             m.Solve();
             if (m.contact_count)
-                contacts.emplace_back(m);
+                chunk.push_back(m);
         }
-    }
+    });
+
+    contacts.clear();
+    for (unsigned int i = 0; i < chunkContacts.size(); i++)
+        contacts.insert(contacts.end(), chunkContacts[i].begin(), chunkContacts[i].end());
+
+    PROFILE_COUNT(profiler, CounterContactsGenerated, contacts.size());
+}
+
+// orders overlaps by ids of sensors and then of visitors
+static bool CompareOverlaps(const SensorEvent& a, const SensorEvent& b)
+{
+    if (a.sensorId != b.sensorId)
+        return a.sensorId < b.sensorId;
+    return a.visitorId < b.visitorId;
+}
+
+void World::DetectSensors(JobSystem& js)
+{
+    PROFILE_SCOPE(profiler, PhaseSensors);
+    unsigned int count = (unsigned int)sensorPairs.size();
+    chunkOverlaps.resize((count + pairGrain - 1) / pairGrain);
+
+    js.ParallelFor(count, pairGrain, [&](unsigned int begin, unsigned int end)
+    {
+        std::vector<SensorEvent>& chunk = chunkOverlaps[begin / pairGrain];
+        chunk.clear();
+        for (unsigned int i = begin; i < end; i++)
+        {
+            RigidBody* A = sensorPairs[i].bodyA;
+            RigidBody* B = sensorPairs[i].bodyB;
+            if (!TestOverlap(A, B))
+                continue;
+
+            if (A->isSensor)
+                chunk.push_back(SensorEvent{ A->id, B->id });
+            else
+                chunk.push_back(SensorEvent{ B->id, A->id });
+        }
+    });
+
+    overlaps.swap(previousOverlaps);
+    overlaps.clear();
+    for (unsigned int i = 0; i < chunkOverlaps.size(); i++)
+        overlaps.insert(overlaps.end(), chunkOverlaps[i].begin(), chunkOverlaps[i].end());
+    std::sort(overlaps.begin(), overlaps.end(), CompareOverlaps);
+
+    // events are differences between sorted overlaps of this and of the previous step
+    sensorBegins.clear();
+    sensorEnds.clear();
+    std::set_difference(overlaps.begin(), overlaps.end(), previousOverlaps.begin(), previousOverlaps.end(),
+        std::back_inserter(sensorBegins), CompareOverlaps);
+    std::set_difference(previousOverlaps.begin(), previousOverlaps.end(), overlaps.begin(), overlaps.end(),
+        std::back_inserter(sensorEnds), CompareOverlaps);
+}
 
-    for (int i = 0; i < bodies.size(); i++)
-        IntegrateForce(bodies[i], dt);
+void World::PrepareContacts(JobSystem& js)
+{
+    PROFILE_SCOPE(profiler, PhasePrepareContacts);
+    js.ParallelFor((unsigned int)contacts.size(), contactGrain, [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int i = begin; i < end; i++)
+            contacts[i].Initialize(settings);
+    });
+}
 
-    for (int j = 0; j < iterations; j++)
+void World::IntegrateForces(JobSystem& js)
+{
+    PROFILE_SCOPE(profiler, PhaseIntegrateForces);
+    js.ParallelFor((unsigned int)bodies.size(), bodyGrain, [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int i = begin; i < end; i++)
+            IntegrateForce(bodies[i], settings.gravity, settings.dt);
+    });
+
+    PROFILE_COUNT(profiler, CounterBodiesIntegrated, bodies.size());
+}
+
+void World::SolveContacts()
+{
+    PROFILE_SCOPE(profiler, PhaseSolve);
+    // contacts share bodies, so impulses are applied sequentially
+    for (unsigned int j = 0; j < settings.iterations; j++)
     {
-        for (int i = 0; i < contacts.size(); i++)
+        TRACE_SCOPE_COUNT("SolverIteration", contacts.size());
+        for (unsigned int i = 0; i < contacts.size(); i++)
             contacts[i].ApplyImpuls();
     }
-        
-    for (int i = 0; i < bodies.size(); i++)
-        IntegrateVelocity(bodies[i], dt);
 
-    for (int i = 0; i < contacts.size(); i++)
-        contacts[i].CorrectPosition();
+    PROFILE_COUNT(profiler, CounterSolverIterations, settings.iterations);
+}
+
+// orders pairs by ids of the first and then of the second body
+static bool ComparePairs(const ContactEvent& a, const ContactEvent& b)
+{
+    if (a.bodyA != b.bodyA)
+        return a.bodyA < b.bodyA;
+    return a.bodyB < b.bodyB;
+}
+
+void World::ReportContacts()
+{
+    PROFILE_SCOPE(profiler, PhaseContactEvents);
 
-    for (int i = 0; i < bodies.size(); i++)
+    // contacts come from pairs sorted by ids, so touching pairs are already in order;
+    // contacts of one pair with a chain follow each other, so only the first one is counted
+    touching.swap(previousTouching);
+    touching.clear();
+    hits.clear();
+    for (unsigned int i = 0; i < contacts.size(); i++)
     {
-        RigidBody* b = bodies[i];
-        b->force.x = 0;
-        b->force.y = 0;
-        b->torque = 0;
+        const ContactPoint& contact = contacts[i];
+        if (touching.empty() || touching.back().bodyA != contact.bodyA->id || touching.back().bodyB != contact.bodyB->id)
+            touching.push_back(ContactEvent{ contact.bodyA->id, contact.bodyB->id });
+
+        if (contact.normalImpulse >= hitThreshold)
+        {
+            Vector2D point = contact.contacts[0];
+            if (contact.contact_count == 2)
+                point = (contact.contacts[0] + contact.contacts[1]) * 0.5f;
+            hits.push_back(HitEvent{ contact.bodyA->id, contact.bodyB->id, point, contact.normal, contact.normalImpulse });
+        }
     }
+
+    contactBegins.clear();
+    contactEnds.clear();
+    std::set_difference(touching.begin(), touching.end(), previousTouching.begin(), previousTouching.end(),
+        std::back_inserter(contactBegins), ComparePairs);
+    std::set_difference(previousTouching.begin(), previousTouching.end(), touching.begin(), touching.end(),
+        std::back_inserter(contactEnds), ComparePairs);
 }
 
-void World::Render()
+void World::IntegrateVelocities(JobSystem& js)
 {
-    for (int i = 0; i < bodies.size(); i++)
+    PROFILE_SCOPE(profiler, PhaseIntegrateVelocities);
+    js.ParallelFor((unsigned int)bodies.size(), bodyGrain, [&](unsigned int begin, unsigned int end)
     {
-        RigidBody* b = bodies[i];
-        b->shape->Draw();
-    }
+        for (unsigned int i = begin; i < end; i++)
+            IntegrateVelocity(bodies[i], settings.gravity, settings.dt);
+    });
+}
+
+void World::CorrectPositions()
+{
+    PROFILE_SCOPE(profiler, PhaseCorrectPositions);
+    for (unsigned int i = 0; i < contacts.size(); i++)
+        contacts[i].CorrectPosition();
+}
+
+void World::ClearForces(JobSystem& js)
+{
+    PROFILE_SCOPE(profiler, PhaseClearForces);
+    js.ParallelFor((unsigned int)bodies.size(), bodyGrain, [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int i = begin; i < end; i++)
+        {
+            RigidBody* b = bodies[i];
+            b->force.x = 0;
+            b->force.y = 0;
+            b->torque = 0;
+        }
+    });
+}
+
+void World::ResetEvents()
+{
+    touching.clear();
+    previousTouching.clear();
+    overlaps.clear();
+    previousOverlaps.clear();
+    contactBegins.clear();
+    contactEnds.clear();
+    hits.clear();
+    sensorBegins.clear();
+    sensorEnds.clear();
+}
+
+void World::RefreshBroadphase()
+{
+    UpdateBroadphase(jobs ? *jobs : JobSystem::Serial());
+}
+
+bool World::RayCast(const Vector2D& start, const Vector2D& end, RayHit& hit) const
+{
+    Vector2D delta = end - start;
+    bool found = false;
+    broadphase.RayCast(start, end, [&](int proxy, float maxFraction)
+    {
+        RigidBody* body = broadphase.GetBody(proxy);
+        float fraction;
+        Vector2D normal;
+        if (!body->shape->RayCast(start, delta, maxFraction, fraction, normal))
+            return maxFraction;
+
+        // ties are resolved by ids, so the result doesn't depend on the shape of the tree
+        if (found && fraction == hit.fraction && hit.body->id < body->id)
+            return maxFraction;
+
+        found = true;
+        hit.body = body;
+        hit.fraction = fraction;
+        hit.normal = normal;
+        hit.point = start + delta * fraction;
+        return fraction;
+    });
+    return found;
+}
 
+void World::RayCastAll(const Vector2D& start, const Vector2D& end, std::vector<RayHit>& hits) const
+{
+    Vector2D delta = end - start;
+    hits.clear();
+    broadphase.RayCast(start, end, [&](int proxy, float maxFraction)
+    {
+        RayHit hit;
+        hit.body = broadphase.GetBody(proxy);
+        if (hit.body->shape->RayCast(start, delta, maxFraction, hit.fraction, hit.normal))
+        {
+            hit.point = start + delta * hit.fraction;
+            hits.push_back(hit);
+        }
+        return maxFraction;
+    });
+
+    std::sort(hits.begin(), hits.end(), [](const RayHit& a, const RayHit& b)
+    {
+        if (a.fraction != b.fraction)
+            return a.fraction < b.fraction;
+        return a.body->id < b.body->id;
+    });
+}
+
+void World::QueryAABB(const AABB& box, std::vector<RigidBody*>& result) const
+{
+    // fat boxes only select candidates; the exact test uses the tight box
+    result.clear();
+    broadphase.Query(box, [&](int proxy)
+    {
+        RigidBody* body = broadphase.GetBody(proxy);
+        if (body->shape->GetAABB().Overlaps(box))
+            result.push_back(body);
+        return true;
+    });
+
+    // order of the tree changes from step to step; results come in a stable order
+    std::sort(result.begin(), result.end(), [](const RigidBody* a, const RigidBody* b) { return a->id < b->id; });
+}
+
+void World::QueryPoint(const Vector2D& point, std::vector<RigidBody*>& result) const
+{
+    result.clear();
+    broadphase.Query(AABB(point, point), [&](int proxy)
+    {
+        RigidBody* body = broadphase.GetBody(proxy);
+        if (body->shape->Contains(point))
+            result.push_back(body);
+        return true;
+    });
+
+    std::sort(result.begin(), result.end(), [](const RigidBody* a, const RigidBody* b) { return a->id < b->id; });
+}
+
+void World::CollectVisible(const AABB& view, std::vector<RigidBody*>& visible) const
+{
+    // fat boxes are enough for drawing; a body slightly outside the view costs less than testing its shape
+    visible.clear();
+    broadphase.Query(view, [&](int proxy)
+    {
+        visible.push_back(broadphase.GetBody(proxy));
+        return true;
+    });
+
+    // order of the tree changes from step to step; overlapping bodies are drawn in a stable order
+    std::sort(visible.begin(), visible.end(), [](const RigidBody* a, const RigidBody* b) { return a->id < b->id; });
+}
+
+void World::Render(const AABB& view, float pixelsPerUnit)
+{
+    renderBatch.Build(*this, view, pixelsPerUnit, jobs ? *jobs : JobSystem::Serial());
+    renderBatch.Submit();
 }
@@ -6,32 +6,239 @@
 #define WORLD_H
 
 #include "Math.h"
+#include "Constans.h"
+
+// pair of bodies which may collide
+struct BodyPair
+{
+    RigidBody* bodyA;
+    RigidBody* bodyB;
+};
+
+
+// overlap of a sensor with another body
+struct SensorEvent
+{
+    unsigned int sensorId;
+    unsigned int visitorId;
+};
+
+
+// pair of bodies which started or stopped touching
+struct ContactEvent
+{
+    unsigned int bodyA;     // the smaller id
+    unsigned int bodyB;
+};
+
+
+// contact whose impulse during a step reached World::hitThreshold
+struct HitEvent
+{
+    unsigned int bodyA;     // the smaller id
+    unsigned int bodyB;
+    Vector2D point;         // middle of contact points
+    Vector2D normal;        // from bodyA to bodyB
+    float impulse;          // sum of normal impulses of the step in [ Newton * second ]
+};
+
+
+// intersection of a ray with a body
+struct RayHit
+{
+    RigidBody* body;
+    Vector2D point;
+    Vector2D normal;        // normal vector of the surface of the body
+    float fraction;         // position of the point on the ray: start + fraction * ( end - start )
+};
+
 
 // World class
 class World
 {
 public:
-    float dt;
-    unsigned int iterations;
+    WorldSettings settings;
     std::vector<RigidBody*> bodies;
     std::vector<ContactPoint> contacts;
+    unsigned int nextBodyId;
+
+    // number of carried out steps
+    unsigned long long stepIndex;
+
+    // changes requested from other threads; they are applied at the beginning of Step
+    CommandQueue commands;
+
+    // tree of fat boxes of all bodies, which finds pairs of bodies that may collide
+    AABBTree broadphase;
+
+    // bodies removed during the last step; they are deleted at the beginning of the next step unless someone takes them over
+    std::vector<RigidBody*> removedBodies;
+
+    // job system executing phases of the step; nullptr means serial execution on the calling thread
+    JobSystem* jobs;
+
+    // recorder which appends state of bodies after every step; nullptr means no recording
+    TrajectoryRecorder* recorder;
+
+    // log of applied commands for replaying the session; nullptr means no logging
+    InputLog* inputLog;
+
+    // shared memory to which state of bodies is published after every step; nullptr means no publishing
+    SharedStateExport* exporter;
 
-    // constructor
+    // overlaps of sensors which began and ended during the last step, in order of ids of sensors and visitors;
+    // bodies are given by ids, so the end of an overlap with a removed body is reported too
+    std::vector<SensorEvent> sensorBegins;
+    std::vector<SensorEvent> sensorEnds;
+
+    // pairs of bodies which started and stopped touching during the last step and contacts hit harder than hitThreshold,
+    // in order of ids; they are plain arrays, so they can be read in bulk or split between threads
+    std::vector<ContactEvent> contactBegins;
+    std::vector<ContactEvent> contactEnds;
+    std::vector<HitEvent> hits;
+
+    // smallest normal impulse of a contact which is reported in hits in [ Newton * second ]; FLT_MAX turns hits off
+    float hitThreshold;
+
+#if defined(RIGIDBODY_PROFILE)
+    // times of phases and amounts of work of the last steps; without RIGIDBODY_PROFILE the world has no profiler
+    Profiler profiler;
+#endif
+
+    // constructor v1
     // _dt - constant which is use in integration
     // _iterations - number of iterations to animate
     World(float _dt, unsigned int _iterations);
 
+    // constructor v2
+    // _settings - physical parameters of creating world
+    World(const WorldSettings& _settings);
+
+    // destructor - deletes all bodies
+    ~World();
+
     // adds a new RigidBody
     // _shape - poiter to shape, creating body will be have this shape
     // ( _x, _y ) - pointer to center body position
     RigidBody* Add(Shape* _shape, int _x, int _y);
 
+    // adds a new RigidBody with given initial state and material
+    // _shape - poiter to shape, creating body will be have this shape
+    // definition - initial state and material of the body
+    RigidBody* Add(const Shape* _shape, const BodyDefinition& definition);
+
+    // adds many bodies at once; storage is reserved up front, mass properties are calculated
+    // in parallel and the broadphase is built once top-down instead of inserting every body
+    // shapes - array of pointers to shapes of creating bodies
+    // definitions - array of initial states and materials, one for each shape
+    // count - number of creating bodies
+    // returns index of the first added body in bodies
+    unsigned int AddBatch(const Shape* const* shapes, const BodyDefinition* definitions, unsigned int count);
+
+    // removes a body from the world and moves it to removedBodies
+    // body - pointer to body to remove
+    void Remove(RigidBody* body);
+
+    // returns body with given id or nullptr if there is no such body
+    // id - id of the body to find
+    RigidBody* Find(unsigned int id);
+
+    // sets job system which executes phases of the step
+    // _jobs - pointer to job system; nullptr means serial execution
+    void SetJobSystem(JobSystem* _jobs);
+
+    // sets recorder of trajectories
+    // _recorder - pointer to opened recorder; nullptr stops recording
+    void SetRecorder(TrajectoryRecorder* _recorder);
+
+    // sets log of applied commands
+    // _inputLog - pointer to opened log; nullptr stops logging
+    void SetInputLog(InputLog* _inputLog);
+
+    // sets shared memory for external visualizers
+    // _exporter - pointer to opened export; nullptr stops publishing
+    void SetExporter(SharedStateExport* _exporter);
+
     // carries out one frame of simulation 
     void Step();
 
-    // draws a current world
-    void Render();
+    // updates boxes of bodies in the broadphase; Step does it only at its end, so it is needed
+    // after transforms of bodies were changed outside of Step, e.g. SetOrientation of an added body
+    void RefreshBroadphase();
+
+    // forgets touching pairs and overlaps of sensors and clears events of the last step, so the next step
+    // reports a begin for every pair which touches then; used when the content of the world is replaced
+    void ResetEvents();
+
+    // finds the first body crossed by segment from start to end; returns false if there is none
+    // start - beginning of the ray
+    // end - end of the ray
+    // hit - filled with the closest intersection
+    bool RayCast(const Vector2D& start, const Vector2D& end, RayHit& hit) const;
+
+    // finds all bodies crossed by segment from start to end, sorted by distance from start
+    // start - beginning of the ray
+    // end - end of the ray
+    // hits - filled with entry points of crossed bodies
+    void RayCastAll(const Vector2D& start, const Vector2D& end, std::vector<RayHit>& hits) const;
+
+    // finds bodies whose boxes overlap the box, in order of ids
+    // box - tested box
+    // result - filled with found bodies
+    void QueryAABB(const AABB& box, std::vector<RigidBody*>& result) const;
+
+    // finds bodies which contain the point, in order of ids
+    // point - tested point
+    // result - filled with found bodies
+    void QueryPoint(const Vector2D& point, std::vector<RigidBody*>& result) const;
+
+    // collects bodies which may be seen in the view, in order of ids; uses boxes of the broadphase
+    // view - visible part of the world
+    // visible - filled with found bodies
+    void CollectVisible(const AABB& view, std::vector<RigidBody*>& visible) const;
+
+    // draws bodies of a current world which are in the view with one draw call
+    // view - visible part of the world
+    // pixelsPerUnit - scale of the view, which chooses level of detail of circles
+    void Render(const AABB& view, float pixelsPerUnit = defaultPixelsPerUnit);
+
+private:
+    // keeps touching pairs and overlaps of sensors of saved steps
+    friend class SnapshotBuffer;
+
+    std::vector<AABB> boxes;
+    std::vector<BodyPair> pairs;
+    std::vector<std::vector<BodyPair>> chunkPairs;
+    std::vector<std::vector<ContactPoint>> chunkContacts;
+
+    // pairs with a sensor and overlaps of sensors of the last two steps
+    std::vector<BodyPair> sensorPairs;
+    std::vector<SensorEvent> overlaps;
+    std::vector<SensorEvent> previousOverlaps;
+    std::vector<std::vector<SensorEvent>> chunkOverlaps;
+
+    // touching pairs of the last two steps
+    std::vector<ContactEvent> touching;
+    std::vector<ContactEvent> previousTouching;
+
+    // buffer of Render
+    RenderBatch renderBatch;
+
+    // applies all pending commands in order of pushing
+    void ApplyCommands();
 
+    // phases of the step, executed as dependent jobs
+    void UpdateBroadphase(JobSystem& js);
+    void FindPairs(JobSystem& js);
+    void Collide(JobSystem& js);
+    void DetectSensors(JobSystem& js);
+    void PrepareContacts(JobSystem& js);
+    void IntegrateForces(JobSystem& js);
+    void SolveContacts();
+    void ReportContacts();
+    void IntegrateVelocities(JobSystem& js);
+    void CorrectPositions();
+    void ClearForces(JobSystem& js);
 };
 
-#endif // WORLD_H
\ No newline at end of file
+#endif // WORLD_H
@@ -0,0 +1,425 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#include "IncludesManager.h"
+#include <cstdio>
+
+static_assert(sizeof(WorldFileHeader) == 96, "world file header layout changed");
+static_assert(sizeof(BodyRecord) == 112, "world file body record layout changed");
+static_assert(sizeof(VertexRecord) == 16, "world file vertex record layout changed");
+static_assert(sizeof(ContactRecord) == 56, "world file contact record layout changed");
+
+// returns offset rounded up to a multiple of 8
+static uint64_t Align(uint64_t offset)
+{
+    return (offset + 7) & ~(uint64_t)7;
+}
+
+// returns index of the body in bodies, which are sorted by id
+static uint32_t IndexOf(const World& world, const RigidBody* body)
+{
+    std::vector<RigidBody*>::const_iterator it = std::lower_bound(world.bodies.begin(), world.bodies.end(), body->id,
+        [](const RigidBody* b, unsigned int value) { return b->id < value; });
+    return (uint32_t)(it - world.bodies.begin());
+}
+
+
+bool SaveWorld(const World& world, const char* path)
+{
+    std::vector<BodyRecord> bodies(world.bodies.size());
+    std::vector<VertexRecord> vertices;
+    std::vector<ContactRecord> contacts(world.contacts.size());
+
+    for (unsigned int i = 0; i < world.bodies.size(); i++)
+    {
+        const RigidBody* b = world.bodies[i];
+        BodyRecord& record = bodies[i];
+        memset(&record, 0, sizeof(record));
+
+        record.id = b->id;
+        record.shapeType = b->shape->GetType();
+        record.position[0] = b->position.x;
+        record.position[1] = b->position.y;
+        record.velocity[0] = b->velocity.x;
+        record.velocity[1] = b->velocity.y;
+        record.force[0] = b->force.x;
+        record.force[1] = b->force.y;
+        record.angularVelocity = b->angularVelocity;
+        record.torque = b->torque;
+        record.orientation = b->orientation;
+        record.mass = b->mass;
+        record.inverseMass = b->inverseMass;
+        record.inertialMoment = b->inertialMoment;
+        record.inverseInertialMoment = b->inverseInertialMoment;
+        record.staticFriction = b->staticFriction;
+        record.kineticFriction = b->kinetcFriction;
+        record.restitution = b->restitution;
+        record.color[0] = b->bodyColor.red;
+        record.color[1] = b->bodyColor.green;
+        record.color[2] = b->bodyColor.blue;
+        record.filterCategory = b->filter.category;
+        record.filterMask = b->filter.mask;
+        record.filterGroup = b->filter.group;
+        record.isSensor = b->isSensor;
+
+        if (record.shapeType == Shape::CircleID)
+        {
+            record.radius = ((const Circle*)b->shape)->radius;
+        }
+        else if (record.shapeType == Shape::CapsuleID)
+        {
+            // ends of the core segment in coordinates of the body
+            const Capsule* capsule = (const Capsule*)b->shape;
+            record.radius = capsule->radius;
+            record.firstVertex = (uint32_t)vertices.size();
+            record.vertexCount = 2;
+            for (int j = 0; j < 2; j++)
+            {
+                VertexRecord vertex;
+                memset(&vertex, 0, sizeof(vertex));
+                vertex.vertex[0] = j == 0 ? -capsule->halfLength : capsule->halfLength;
+                vertices.push_back(vertex);
+            }
+        }
+        else if (record.shapeType == Shape::ChainID)
+        {
+            const Chain* chain = (const Chain*)b->shape;
+            record.firstVertex = (uint32_t)vertices.size();
+            record.vertexCount = (uint32_t)chain->vertices.size();
+            record.isLoop = chain->loop;
+            for (unsigned int j = 0; j < chain->vertices.size(); j++)
+            {
+                VertexRecord vertex;
+                vertex.vertex[0] = chain->vertices[j].x;
+                vertex.vertex[1] = chain->vertices[j].y;
+                vertex.normal[0] = chain->normals[j].x;
+                vertex.normal[1] = chain->normals[j].y;
+                vertices.push_back(vertex);
+            }
+        }
+        else
+        {
+            const Poly* poly = (const Poly*)b->shape;
+            record.firstVertex = (uint32_t)vertices.size();
+            record.vertexCount = poly->verticesCount;
+            for (int j = 0; j < poly->verticesCount; j++)
+            {
+                VertexRecord vertex;
+                vertex.vertex[0] = poly->verticesArray[j].x;
+                vertex.vertex[1] = poly->verticesArray[j].y;
+                vertex.normal[0] = poly->normalVectors[j].x;
+                vertex.normal[1] = poly->normalVectors[j].y;
+                vertices.push_back(vertex);
+            }
+        }
+    }
+
+    for (unsigned int i = 0; i < world.contacts.size(); i++)
+    {
+        const ContactPoint& c = world.contacts[i];
+        ContactRecord& record = contacts[i];
+        memset(&record, 0, sizeof(record));
+
+        record.bodyA = IndexOf(world, c.bodyA);
+        record.bodyB = IndexOf(world, c.bodyB);
+        record.contactCount = c.contact_count;
+        record.penetration = c.penetration;
+        record.normal[0] = c.normal.x;
+        record.normal[1] = c.normal.y;
+        for (int j = 0; j < c.contact_count; j++)
+        {
+            record.contacts[j][0] = c.contacts[j].x;
+            record.contacts[j][1] = c.contacts[j].y;
+        }
+        record.restitution = c.resultantRestitution;
+        record.staticFriction = c.resultantStaticFriction;
+        record.kineticFriction = c.resultantKineticFriction;
+    }
+
+    WorldFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, worldFileMagic, sizeof(header.magic));
+    header.version = worldFileVersion;
+    header.byteOrder = worldFileByteOrder;
+    header.gravity[0] = world.settings.gravity.x;
+    header.gravity[1] = world.settings.gravity.y;
+    header.dt = world.settings.dt;
+    header.iterations = world.settings.iterations;
+    header.penetrationAllowance = world.settings.penetrationAllowance;
+    header.penetrationPercent = world.settings.penetrationPercent;
+    header.nextBodyId = world.nextBodyId;
+    header.stepIndex = world.stepIndex;
+    header.bodyCount = (uint32_t)bodies.size();
+    header.vertexCount = (uint32_t)vertices.size();
+    header.contactCount = (uint32_t)contacts.size();
+    header.bodiesOffset = Align(sizeof(header));
+    header.verticesOffset = Align(header.bodiesOffset + bodies.size() * sizeof(BodyRecord));
+    header.contactsOffset = Align(header.verticesOffset + vertices.size() * sizeof(VertexRecord));
+    header.fileSize = header.contactsOffset + contacts.size() * sizeof(ContactRecord);
+
+    FILE* file;
+    if (fopen_s(&file, path, "wb") != 0)
+        return false;
+
+    // sections are written at their offsets, gaps are filled with zeros
+    std::vector<char> image((size_t)header.fileSize, 0);
+    memcpy(&image[0], &header, sizeof(header));
+    if (!bodies.empty())
+        memcpy(&image[(size_t)header.bodiesOffset], bodies.data(), bodies.size() * sizeof(BodyRecord));
+    if (!vertices.empty())
+        memcpy(&image[(size_t)header.verticesOffset], vertices.data(), vertices.size() * sizeof(VertexRecord));
+    if (!contacts.empty())
+        memcpy(&image[(size_t)header.contactsOffset], contacts.data(), contacts.size() * sizeof(ContactRecord));
+
+    bool written = fwrite(image.data(), 1, image.size(), file) == image.size();
+    return fclose(file) == 0 && written;
+}
+
+// checks whether a section of count records of given size starts after the header and ends in the file;
+// the count is compared with the space left instead of multiplied, so crafted counts can't overflow
+static bool FitsInFile(uint64_t offset, uint32_t count, uint64_t recordSize, uint64_t fileSize)
+{
+    return offset >= sizeof(WorldFileHeader) && offset % 8 == 0 && offset <= fileSize && count <= (fileSize - offset) / recordSize;
+}
+
+// checks whether the header describes sections which fit in the file
+static bool Validate(const WorldFileHeader* header, uint64_t size)
+{
+    if (size < sizeof(WorldFileHeader))
+        return false;
+    if (memcmp(header->magic, worldFileMagic, sizeof(header->magic)) != 0)
+        return false;
+    if (header->version != worldFileVersion || header->byteOrder != worldFileByteOrder)
+        return false;
+    if (header->fileSize > size)
+        return false;
+
+    WorldSettings settings;
+    settings.gravity = Vector2D(header->gravity[0], header->gravity[1]);
+    settings.dt = header->dt;
+    settings.iterations = header->iterations;
+    settings.penetrationAllowance = header->penetrationAllowance;
+    settings.penetrationPercent = header->penetrationPercent;
+    if (!settings.IsValid())
+        return false;
+
+    return FitsInFile(header->bodiesOffset, header->bodyCount, sizeof(BodyRecord), header->fileSize) &&
+           FitsInFile(header->verticesOffset, header->vertexCount, sizeof(VertexRecord), header->fileSize) &&
+           FitsInFile(header->contactsOffset, header->contactCount, sizeof(ContactRecord), header->fileSize);
+}
+
+// creates body from its record; returns nullptr if the record is invalid
+static RigidBody* CreateBody(const BodyRecord& record, const VertexRecord* vertices, uint32_t vertexCount)
+{
+    float state[] = { record.position[0], record.position[1], record.velocity[0], record.velocity[1], record.force[0], record.force[1],
+        record.angularVelocity, record.torque, record.orientation, record.mass, record.inverseMass, record.inertialMoment,
+        record.inverseInertialMoment, record.staticFriction, record.kineticFriction, record.restitution };
+    if (!allFinite(state, sizeof(state) / sizeof(state[0])))
+        return nullptr;
+
+    Shape* shape;
+    if (record.shapeType == Shape::CircleID)
+    {
+        if (!std::isfinite(record.radius) || !(record.radius > 0.0f))
+            return nullptr;
+
+        shape = new Circle(record.radius);
+    }
+    else if (record.shapeType == Shape::PolygonID)
+    {
+        if (record.vertexCount < 3 || record.vertexCount > MaxPolyVertexCount ||
+            (uint64_t)record.firstVertex + record.vertexCount > vertexCount)
+            return nullptr;
+
+        Poly* poly = new Poly();
+        poly->verticesCount = record.vertexCount;
+        for (uint32_t i = 0; i < record.vertexCount; i++)
+        {
+            const VertexRecord& vertex = vertices[record.firstVertex + i];
+            if (!allFinite(vertex.vertex, 2) || !allFinite(vertex.normal, 2))
+            {
+                delete poly;
+                return nullptr;
+            }
+            poly->verticesArray[i] = Vector2D(vertex.vertex[0], vertex.vertex[1]);
+            poly->normalVectors[i] = Vector2D(vertex.normal[0], vertex.normal[1]);
+        }
+        shape = poly;
+    }
+    else if (record.shapeType == Shape::CapsuleID)
+    {
+        if (record.vertexCount != 2 || (uint64_t)record.firstVertex + record.vertexCount > vertexCount)
+            return nullptr;
+        float halfLength = vertices[record.firstVertex + 1].vertex[0];
+        if (!std::isfinite(record.radius) || !(record.radius > 0.0f) || !std::isfinite(halfLength) || !(halfLength > EPSILON))
+            return nullptr;
+
+        shape = new Capsule(halfLength, record.radius);
+    }
+    else if (record.shapeType == Shape::ChainID)
+    {
+        if ((uint64_t)record.firstVertex + record.vertexCount > vertexCount || record.isLoop > 1)
+            return nullptr;
+
+        // normals are calculated again by the chain
+        std::vector<Vector2D> points(record.vertexCount);
+        for (uint32_t i = 0; i < record.vertexCount; i++)
+        {
+            if (!allFinite(vertices[record.firstVertex + i].vertex, 2))
+                return nullptr;
+            points[i] = Vector2D(vertices[record.firstVertex + i].vertex[0], vertices[record.firstVertex + i].vertex[1]);
+        }
+        shape = Chain::FromStored(points.data(), (int)points.size(), record.isLoop != 0);
+        if (!shape)
+            return nullptr;
+    }
+    else
+    {
+        return nullptr;
+    }
+
+    RigidBody* b = new RigidBody(shape);
+    b->id = record.id;
+    b->position = Vector2D(record.position[0], record.position[1]);
+    b->velocity = Vector2D(record.velocity[0], record.velocity[1]);
+    b->force = Vector2D(record.force[0], record.force[1]);
+    b->angularVelocity = record.angularVelocity;
+    b->torque = record.torque;
+    b->mass = record.mass;
+    b->inverseMass = record.inverseMass;
+    b->inertialMoment = record.inertialMoment;
+    b->inverseInertialMoment = record.inverseInertialMoment;
+    b->SetFrictions(record.staticFriction, record.kineticFriction, record.restitution);
+    b->SetColor(record.color[0], record.color[1], record.color[2]);
+    CollisionFilter filter;
+    filter.category = record.filterCategory;
+    filter.mask = record.filterMask;
+    filter.group = record.filterGroup;
+    b->SetFilter(filter);
+    b->isSensor = record.isSensor != 0;
+    b->SetOrientation(record.orientation);
+    return b;
+}
+
+bool LoadWorld(World& world, const char* path)
+{
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < (long long)sizeof(WorldFileHeader))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    const char* view = mapping ? (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view)
+    {
+        if (mapping)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    const WorldFileHeader* header = (const WorldFileHeader*)view;
+    bool valid = Validate(header, (uint64_t)size.QuadPart);
+
+    const BodyRecord* bodyRecords = (const BodyRecord*)(view + header->bodiesOffset);
+    const VertexRecord* vertexRecords = (const VertexRecord*)(view + header->verticesOffset);
+    const ContactRecord* contactRecords = (const ContactRecord*)(view + header->contactsOffset);
+
+    std::vector<RigidBody*> bodies;
+    if (valid)
+    {
+        bodies.resize(header->bodyCount);
+
+        // records are independent, so bodies are created in parallel
+        JobSystem& js = world.jobs ? *world.jobs : JobSystem::Serial();
+        js.ParallelFor(header->bodyCount, 1024, [&](unsigned int begin, unsigned int end)
+        {
+            for (unsigned int i = begin; i < end; i++)
+                bodies[i] = CreateBody(bodyRecords[i], vertexRecords, header->vertexCount);
+        });
+
+        for (unsigned int i = 0; i < bodies.size(); i++)
+        {
+            if (!bodies[i] || (i > 0 && bodies[i]->id <= bodyRecords[i - 1].id))
+                valid = false;
+        }
+
+        // ids of new bodies continue after the loaded ones, so they stay sorted and unique
+        if (header->bodyCount > 0 && header->nextBodyId <= bodyRecords[header->bodyCount - 1].id)
+            valid = false;
+        for (unsigned int i = 0; i < header->contactCount; i++)
+        {
+            const ContactRecord& record = contactRecords[i];
+            if (record.bodyA >= header->bodyCount || record.bodyB >= header->bodyCount || record.contactCount < 0 || record.contactCount > 2 ||
+                !std::isfinite(record.penetration) || !allFinite(record.normal, 2) || !allFinite(&record.contacts[0][0], 4))
+                valid = false;
+        }
+    }
+
+    if (!valid)
+    {
+        for (unsigned int i = 0; i < bodies.size(); i++)
+            delete bodies[i];
+        UnmapViewOfFile(view);
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    // the file is correct, so the old content can be replaced; commands and removed bodies of the old world go too
+    for (unsigned int i = 0; i < world.bodies.size(); i++)
+        delete world.bodies[i];
+    world.bodies.swap(bodies);
+    for (unsigned int i = 0; i < world.removedBodies.size(); i++)
+        delete world.removedBodies[i];
+    world.removedBodies.clear();
+    CommandQueue::Release(world.commands.TakeAll());
+    world.contacts.clear();
+    world.ResetEvents();
+    world.broadphase.Clear();
+
+    world.settings.gravity = Vector2D(header->gravity[0], header->gravity[1]);
+    world.settings.dt = header->dt;
+    world.settings.iterations = header->iterations;
+    world.settings.penetrationAllowance = header->penetrationAllowance;
+    world.settings.penetrationPercent = header->penetrationPercent;
+    world.nextBodyId = header->nextBodyId;
+    world.stepIndex = header->stepIndex;
+
+    for (unsigned int i = 0; i < world.bodies.size(); i++)
+    {
+        RigidBody* b = world.bodies[i];
+        b->proxy = world.broadphase.CreateDetachedProxy(b->shape->GetAABB(), b);
+    }
+    world.broadphase.Rebuild();
+
+    world.contacts.reserve(header->contactCount);
+    for (unsigned int i = 0; i < header->contactCount; i++)
+    {
+        const ContactRecord& record = contactRecords[i];
+        ContactPoint c(world.bodies[record.bodyA], world.bodies[record.bodyB]);
+        c.contact_count = record.contactCount;
+        c.penetration = record.penetration;
+        c.normal = Vector2D(record.normal[0], record.normal[1]);
+        for (int j = 0; j < record.contactCount; j++)
+            c.contacts[j] = Vector2D(record.contacts[j][0], record.contacts[j][1]);
+        c.resultantRestitution = record.restitution;
+        c.resultantStaticFriction = record.staticFriction;
+        c.resultantKineticFriction = record.kineticFriction;
+        c.penetrationAllowance = world.settings.penetrationAllowance;
+        c.penetrationPercent = world.settings.penetrationPercent;
+        world.contacts.push_back(c);
+    }
+
+    UnmapViewOfFile(view);
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return true;
+}
@@ -0,0 +1,121 @@
+/*
+* Copyright (c) 2021 Karol Janic
+*/
+
+#ifndef WORLDFILE_H
+#define WORLDFILE_H
+
+#include <cstdint>
+
+class World;
+
+// binary world file format
+// the file is an image of arrays of fixed size little-endian records, so after mapping it into memory
+// it is read in place; sections start at offsets written in the header and are aligned to 8 bytes
+//
+//   WorldFileHeader
+//   BodyRecord[bodyCount]
+//   VertexRecord[vertexCount]     - vertices and face normals of all polygons and chains, ends of cores of capsules
+//   ContactRecord[contactCount]   - contacts of the last step
+
+const char worldFileMagic[8] = { 'R', 'B', '2', 'D', 'W', 'R', 'L', 'D' };
+const uint32_t worldFileVersion = 5;
+const uint32_t worldFileByteOrder = 0x01020304;
+
+
+struct WorldFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;             // worldFileByteOrder as written by the saving machine
+
+    float gravity[2];
+    float dt;
+    uint32_t iterations;
+    float penetrationAllowance;
+    float penetrationPercent;
+    uint32_t nextBodyId;
+
+    uint32_t bodyCount;
+    uint32_t vertexCount;
+    uint32_t contactCount;
+
+    uint64_t bodiesOffset;
+    uint64_t verticesOffset;
+    uint64_t contactsOffset;
+    uint64_t fileSize;
+
+    uint64_t stepIndex;             // World::stepIndex, so a loaded world continues numbering its steps
+};
+
+
+struct BodyRecord
+{
+    uint32_t id;
+    uint32_t shapeType;             // Shape::ID
+
+    float position[2];
+    float velocity[2];
+    float force[2];
+    float angularVelocity;
+    float torque;
+    float orientation;
+
+    float mass;
+    float inverseMass;
+    float inertialMoment;
+    float inverseInertialMoment;
+
+    float staticFriction;
+    float kineticFriction;
+    float restitution;
+    float color[3];
+
+    float radius;                   // circles, capsules
+    uint32_t firstVertex;           // polygons, chains, capsules - index of the first vertex in the vertex section
+    uint32_t vertexCount;           // polygons, chains, capsules
+    uint32_t isLoop;                // chains - whether the last vertex is connected with the first one
+
+    uint16_t filterCategory;
+    uint16_t filterMask;
+    int16_t filterGroup;
+    uint16_t isSensor;
+    uint32_t reserved;
+};
+
+
+struct VertexRecord
+{
+    float vertex[2];
+    float normal[2];
+};
+
+
+struct ContactRecord
+{
+    uint32_t bodyA;                 // index of the body in the body section
+    uint32_t bodyB;
+    int32_t contactCount;
+    float penetration;
+    float normal[2];
+    float contacts[2][2];
+    float restitution;
+    float staticFriction;
+    float kineticFriction;
+    uint32_t reserved;
+};
+
+
+// saves the whole world to a binary file; returns false if the file can't be written
+// world - world to save
+// path - path of the file
+bool SaveWorld(const World& world, const char* path);
+
+// replaces content of the world with the content of a binary file; returns false if the file is missing or invalid
+// the file is mapped into memory, bodies are created straight from records in parallel and the broadphase is built once;
+// touching pairs and overlaps aren't stored, so the first step after loading reports them as beginning
+// world - world to fill
+// path - path of the file
+bool LoadWorld(World& world, const char* path);
+
+#endif // WORLDFILE_H
@@ -4,10 +4,264 @@
 
 
 #include "FancyWorld.h"
+#include "Viewer.h"
+#include <cstdio>
 
+// repeats a recorded session without a window and prints times of phases of the step
+// path - path of the input log
+// threads - number of threads stepping the world
+// tracePath - path of Chrome trace of the replay or nullptr
+int ReplaySession(const char* path, unsigned int threads, const char* tracePath)
+{
+    InputReplay replay;
+    if (!replay.Open(path))
+    {
+        fprintf(stderr, "can't read input log %s\n", path);
+        return 1;
+    }
+
+    JobSystem jobs(threads);
+    World world(replay.GetSettings());
+    world.SetJobSystem(&jobs);
+    if (tracePath)
+        TraceRecorder::Start();
+
+    // the session is replayed a few seconds past the last command, so the last bodies settle
+    unsigned long long steps = replay.GetStepCount() + (unsigned long long)(5.0f / world.settings.dt);
+    Timer timer;
+    timer.Start();
+    for (unsigned long long i = 0; i < steps; i++)
+        replay.Step(world);
+    timer.Stop();
+
+    if (tracePath && !TraceRecorder::Save(tracePath))
+        fprintf(stderr, "can't write trace %s\n", tracePath);
+
+    printf("replayed %s: seed %u, %zu commands, %llu steps, %zu bodies, %.3f s\n", path, replay.GetSeed(),
+        replay.GetEvents().size(), steps, world.bodies.size(), timer.Elapsed());
+#if defined(RIGIDBODY_PROFILE)
+    printf("last %u steps [ ms ]         min      mean       p99\n", world.profiler.StepCount());
+    for (int phase = 0; phase < PhaseCount; phase++)
+    {
+        ProfileStats stats = world.profiler.GetStats((ProfilePhase)phase);
+        printf("%-22s %9.3f %9.3f %9.3f\n", Profiler::GetName((ProfilePhase)phase), stats.min, stats.mean, stats.p99);
+    }
+#endif
+    return 0;
+}
+
+// repeats a recorded session without a window and builds the render batch of every step
+// the batch built by the job system is compared with one built serially and checked for broken triangles,
+// then times of building and a checksum of the last batch are printed; returns 1 if any batch is wrong
+// path - path of the input log
+// threads - number of threads stepping the world and building the batch
+int BatchSession(const char* path, unsigned int threads)
+{
+    InputReplay replay;
+    if (!replay.Open(path))
+    {
+        fprintf(stderr, "can't read input log %s\n", path);
+        return 1;
+    }
+
+    JobSystem jobs(threads);
+    World world(replay.GetSettings());
+    world.SetJobSystem(&jobs);
+
+    // the same part of the world as the window of Fancy World
+    AABB view(Vector2D(0.0f, 0.0f), Vector2D(80.0f, 60.0f));
+    RenderBatch batch;
+    RenderBatch serial;
+
+    unsigned long long steps = replay.GetStepCount() + (unsigned long long)(5.0f / world.settings.dt);
+    unsigned long long triangles = 0;
+    Timer timer;
+    double building = 0.0;
+    for (unsigned long long i = 0; i < steps; i++)
+    {
+        replay.Step(world);
+
+        timer.Start();
+        batch.Build(world, view, defaultPixelsPerUnit, jobs);
+        timer.Stop();
+        building += timer.Elapsed();
+        serial.Build(world, view, defaultPixelsPerUnit);
+
+        // every body is written to its own range, so the number of threads can't change the batch
+        const std::vector<RenderVertex>& vertices = batch.GetVertices();
+        const std::vector<RenderVertex>& expected = serial.GetVertices();
+        bool valid = vertices.size() % 3 == 0 && vertices.size() == expected.size() &&
+            (vertices.empty() || memcmp(vertices.data(), expected.data(), vertices.size() * sizeof(RenderVertex)) == 0);
+        for (unsigned int v = 0; valid && v < vertices.size(); v++)
+            valid = std::isfinite(vertices[v].x) && std::isfinite(vertices[v].y);
+        if (!valid)
+        {
+            fprintf(stderr, "wrong batch of step %llu\n", i);
+            return 1;
+        }
+        triangles += vertices.size() / 3;
+    }
+
+    double checksum = 0.0;
+    const std::vector<RenderVertex>& vertices = batch.GetVertices();
+    for (unsigned int v = 0; v < vertices.size(); v++)
+        checksum += vertices[v].x + vertices[v].y;
+
+    printf("batched %s: %llu frames, %.1f triangles per frame, building %.3f ms per frame, last frame %zu triangles, checksum %.3f\n",
+        path, steps, steps ? (double)triangles / steps : 0.0, steps ? building * 1000.0 / steps : 0.0, vertices.size() / 3, checksum);
+    return 0;
+}
+
+// returns true if a pattern of file names has exactly one conversion and it is %d with optional flags and width
+// pattern - printf pattern given on the command line
+static bool IsFramePattern(const char* pattern)
+{
+    int conversions = 0;
+    for (const char* c = pattern; *c; c++)
+    {
+        if (*c != '%')
+            continue;
+        if (*++c == '%')
+            continue;
+        while (*c == '0' || *c == '-' || *c == '+' || *c == ' ')
+            c++;
+        while (*c >= '0' && *c <= '9')
+            c++;
+        if (*c != 'd')
+            return false;
+        conversions++;
+    }
+    return conversions == 1;
+}
+
+// repeats a recorded session without a window and draws every step on the processor
+// path - path of the input log
+// output - printf pattern of PNG files with the index of the frame ( frames/%05d.png ) or a .raw file
+//          to which all frames are appended as RGBA bytes, e.g. for ffmpeg -f rawvideo -pix_fmt rgba -s 800x600
+// threads - number of threads stepping and drawing the world
+// returns 1 if the log can't be read, the pattern is wrong or a frame can't be written
+int RenderSession(const char* path, const char* output, unsigned int threads)
+{
+    InputReplay replay;
+    if (!replay.Open(path))
+    {
+        fprintf(stderr, "can't read input log %s\n", path);
+        return 1;
+    }
+
+    size_t length = strlen(output);
+    bool raw = length > 4 && strcmp(output + length - 4, ".raw") == 0;
+    if (!raw && !IsFramePattern(output))
+    {
+        fprintf(stderr, "output %s must contain exactly one %%d, e.g. frames/%%05d.png\n", output);
+        return 1;
+    }
+    FILE* rawFile = nullptr;
+    if (raw && fopen_s(&rawFile, output, "wb") != 0)
+    {
+        fprintf(stderr, "can't write %s\n", output);
+        return 1;
+    }
+
+    JobSystem jobs(threads);
+    World world(replay.GetSettings());
+    world.SetJobSystem(&jobs);
+
+    // the same part of the world as the window of Fancy World
+    Rasterizer rasterizer(800, 600);
+    AABB view(Vector2D(0.0f, 0.0f), Vector2D(80.0f, 60.0f));
+
+    unsigned long long steps = replay.GetStepCount() + (unsigned long long)(5.0f / world.settings.dt);
+    Timer timer;
+    double drawing = 0.0;
+    double saving = 0.0;
+    unsigned long long frames = 0;
+    bool failed = false;
+    char name[1024];
+    for (unsigned long long i = 0; i < steps && !failed; i++)
+    {
+        replay.Step(world);
+
+        timer.Start();
+        rasterizer.Draw(world, view, jobs);
+        timer.Stop();
+        drawing += timer.Elapsed();
+
+        timer.Start();
+        bool written;
+        if (raw)
+        {
+            written = rasterizer.WriteRaw(rawFile);
+        }
+        else
+        {
+            snprintf(name, sizeof(name), output, (int)i);
+            written = rasterizer.SavePNG(name);
+        }
+        timer.Stop();
+        saving += timer.Elapsed();
+        if (written)
+            frames++;
+        else
+        {
+            fprintf(stderr, "can't write frame %llu\n", i);
+            failed = true;
+        }
+    }
+
+    if (rawFile && fclose(rawFile) != 0 && !failed)
+    {
+        fprintf(stderr, "can't write %s\n", output);
+        failed = true;
+    }
+
+    // rates are of written frames only; a very short session may take no measurable time
+    printf("rendered %s: %llu frames %ux%u, drawing %.1f frames/s, writing %.1f frames/s\n", path, frames,
+        rasterizer.GetWidth(), rasterizer.GetHeight(), drawing > 0.0 ? frames / drawing : 0.0, saving > 0.0 ? frames / saving : 0.0);
+    return failed ? 1 : 0;
+}
+
+// RigidBody2D                                         - interactive Fancy World
+// RigidBody2D --record session.log                    - interactive Fancy World which logs spawned bodies
+// RigidBody2D --seed 7                                - interactive Fancy World with given seed of random shapes
+// RigidBody2D --replay session.log [threads] [trace]  - headless replay of a logged session
+// RigidBody2D --render session.log out [threads]      - headless replay drawn to PNG or raw frames
+// RigidBody2D --batch session.log [threads]           - headless replay which checks render batches
+// RigidBody2D --export name                           - interactive Fancy World published to shared memory
+// RigidBody2D --view name                             - window drawing a world published by another process
 int main(int argc, char** argv)
 {
+    if (argc > 2 && strcmp(argv[1], "--replay") == 0)
+        return ReplaySession(argv[2], argc > 3 ? (unsigned int)atoi(argv[3]) : 1, argc > 4 ? argv[4] : nullptr);
+
+    if (argc > 2 && strcmp(argv[1], "--batch") == 0)
+        return BatchSession(argv[2], argc > 3 ? (unsigned int)atoi(argv[3]) : 1);
+
+    if (argc > 3 && strcmp(argv[1], "--render") == 0)
+        return RenderSession(argv[2], argv[3], argc > 4 ? (unsigned int)atoi(argv[4]) : 1);
+
+    if (argc > 2 && strcmp(argv[1], "--view") == 0)
+    {
+        const char* name = argv[2];
+        argv[2] = argv[0];
+        return InitViewer(argc - 2, argv + 2, name);
+    }
+
+    // options of Fancy World may be combined, e.g. --seed 7 --record session.log
+    while (argc > 2 && (strcmp(argv[1], "--record") == 0 || strcmp(argv[1], "--export") == 0 || strcmp(argv[1], "--seed") == 0))
+    {
+        if (strcmp(argv[1], "--record") == 0)
+            inputLogPath = argv[2];
+        else if (strcmp(argv[1], "--seed") == 0)
+            seed = (unsigned int)strtoul(argv[2], nullptr, 10);
+        else
+            exportName = argv[2];
+        argv[2] = argv[0];
+        argc -= 2;
+        argv += 2;
+    }
+
     InitFancyWorld(argc, argv);
     //test(argc, argv);
     return 0;
-}
\ No newline at end of file
+}